@@ -48,6 +48,23 @@ namespace dsp56kDebugger
 		m_propsBool.emplace_back(m_grid, "Support dynamic peripheral addressing", m_config.dynamicPeripheralAddressing);
 		m_propsUInt.emplace_back(m_grid, "Max Instructions per Block", m_config.maxInstructionsPerBlock);
 		m_propsBool.emplace_back(m_grid, "Do memory writes via C++", m_config.memoryWritesCallCpp);
+		m_propsBool.emplace_back(m_grid, "Use Compile Queue (interpret new code until compiled)", m_config.useCompileQueue);
+		m_propsUInt.emplace_back(m_grid, "Compile Queue Blocks per Peripheral Step", m_config.compileQueueBlocksPerStep);
+		m_propsUInt.emplace_back(m_grid, "Hot Threshold (interpreted executions before compilation)", m_config.hotThreshold);
+		m_propsBool.emplace_back(m_grid, "Build Superblocks across rarely taken branches", m_config.buildSuperblocks);
+		m_propsUInt.emplace_back(m_grid, "Superblock max taken percentage of a branch", m_config.superblockMaxTakenPercent);
+		m_propsUInt.emplace_back(m_grid, "Max Code Size (bytes, 0 = unlimited)", m_config.maxCodeSize);
+		m_propsBool.emplace_back(m_grid, "Share JIT Runtime between instances (before first compile only)", m_config.shareJitRuntime);
+		m_propsBool.emplace_back(m_grid, "Keep Registers in XMMs across linked Blocks", m_config.keepRegistersAcrossLinkedBlocks);
+		m_propsBool.emplace_back(m_grid, "Link Blocks to Children compiled later", m_config.linkJitBlocksLate);
+		m_propsBool.emplace_back(m_grid, "Link Subroutine Returns (predict RTS target)", m_config.linkSubroutineReturns);
+		m_propsBool.emplace_back(m_grid, "Native DO Loops (LC in host register)", m_config.nativeDoLoops);
+		m_propsBool.emplace_back(m_grid, "Vectorize MAC Loops over X/Y memory", m_config.vectorizeMacLoops);
+		m_propsBool.emplace_back(m_grid, "Share mode-independent Blocks between DSP modes", m_config.shareModeIndependentBlocks);
+		m_propsBool.emplace_back(m_grid, "Specialize AGU N/M values (guarded, speculative)", m_config.specializeAguRegisters);
+		m_propsBool.emplace_back(m_grid, "Count Superblock Instructions once on Entry", m_config.batchInstructionCount);
+		m_propsBool.emplace_back(m_grid, "Run Blocks as Interpreter Closures (no Code Generation)", m_config.closureBlocks);
+		m_propsBool.emplace_back(m_grid, "Share Interpreter Closures between DSP Instances", m_config.shareClosureBlocks);
 
 		for (auto& prop : m_propsBool)
 			prop.prop()->SetAttribute(wxPG_BOOL_USE_CHECKBOX, true);
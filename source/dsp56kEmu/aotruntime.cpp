@@ -0,0 +1,180 @@
+#include "aotruntime.h"
+
+#include "dsp.h"
+#include "interrupts.h"
+#include "opcodeanalysis.h"
+#include "jit.h"
+
+namespace dsp56k
+{
+	AotRuntime::AotRuntime(DSP& _dsp) : m_dsp(_dsp)
+	{
+	}
+
+	void AotRuntime::addEntryPoint(const TWord _pc)
+	{
+		m_entryPoints.push_back(_pc);
+	}
+
+	size_t AotRuntime::analyze()
+	{
+		m_visited.clear();
+		m_blockStarts.clear();
+		m_loopBodyStarts.clear();
+		m_loopBodyEnds.clear();
+		m_loops.clear();
+
+		// every vector is a fast interrupt of two words, long interrupts are reached via the JSR that they contain
+		for(TWord pc = 0; pc < Vba_End; pc += 2)
+		{
+			if(m_dsp.memory().getOpcodeAnalysis(pc).instA == Invalid)
+				continue;
+
+			m_blockStarts.insert(pc);
+			walk(pc);
+		}
+
+		m_blockStarts.insert(m_dsp.getPC().toWord());
+		walk(m_dsp.getPC().toWord());
+
+		for (const auto pc : m_entryPoints)
+		{
+			m_blockStarts.insert(pc);
+			walk(pc);
+		}
+
+		// The last block of a loop body ends at LA. It is the last block start in front of the loop end, unless that is
+		// in front of the body itself, in which case the body consists of a single block starting at the body start
+		for (const auto& it : m_loops)
+		{
+			const auto bodyStart = it.first + m_dsp.memory().getOpcodeAnalysis(it.first).length;
+			const auto loopEnd = it.second;
+
+			auto itEnd = m_blockStarts.lower_bound(loopEnd);
+			if(itEnd == m_blockStarts.begin())
+				continue;
+			--itEnd;
+			if(*itEnd > bodyStart)
+				m_loopBodyEnds.insert(*itEnd);
+		}
+
+		LOG("AOT: Found " << m_blockStarts.size() << " block entry points, " << m_loops.size() << " loops, " << m_visited.size() << " instructions");
+
+		return m_blockStarts.size();
+	}
+
+	void AotRuntime::walk(const TWord _pc)
+	{
+		const auto pSize = m_dsp.memory().sizeP();
+
+		std::vector<TWord> pending{_pc};
+
+		auto addTarget = [&](const TWord _target, const bool _isBlockStart)
+		{
+			if(_target >= pSize)
+				return;
+
+			if(_isBlockStart)
+				m_blockStarts.insert(_target);
+
+			pending.push_back(_target);
+		};
+
+		while(!pending.empty())
+		{
+			auto pc = pending.back();
+			pending.pop_back();
+
+			// a fast interrupt consists of two words only
+			const auto pcMax = pc < Vba_End ? (pc + 2) : pSize;
+
+			while(pc < pcMax && m_visited.insert(pc).second)
+			{
+				const auto& analysis = m_dsp.memory().getOpcodeAnalysis(pc);
+
+				const auto instA = analysis.instA;
+
+				if(instA == Invalid)
+					break;
+
+				const auto flags = analysis.flags;
+				const auto pcNext = pc + analysis.length;
+
+				const auto loopEnd = analysis.loopEnd;
+				if(loopEnd != g_invalidAddress)
+				{
+					m_loops.insert(std::make_pair(pc, loopEnd));
+
+					// the body start is not compiled ahead of time, see compile()
+					m_loopBodyStarts.insert(pcNext);
+					addTarget(loopEnd, true);
+				}
+
+				if(flags & OpFlagBranch)
+				{
+					const auto target = analysis.branchTarget;
+
+					if(target != g_invalidAddress && target != g_dynamicAddress)
+						addTarget(target, true);
+
+					const auto isConditional = hasField(instA, Field_CCCC) || hasField(instA, Field_bbbbb);
+					const auto isSubroutine = (analysis.written & RegisterMask::SSH) != RegisterMask::None;
+
+					// execution continues after the branch if it is not taken or if the subroutine returns
+					if(isConditional || isSubroutine)
+						addTarget(pcNext, true);
+
+					break;
+				}
+
+				if(flags & OpFlagPopPC)
+					break;
+
+				pc = pcNext;
+			}
+		}
+	}
+
+	size_t AotRuntime::compile()
+	{
+		auto& jit = m_dsp.getJit();
+		auto* chain = jit.m_currentChain;
+
+		if(!chain)
+			return 0;
+
+		// Loop body blocks need to know where their loop ends. Register all loops up front, the blocks containing the
+		// DO instructions register them again when they are created
+		for (const auto& it : m_loops)
+			jit.addLoop(it.first, it.second);
+
+		size_t count = 0;
+
+		// Compile in descending order. A block extends until existing code is found, this way each block ends where the
+		// next entry point begins and no block has to be split later because something jumps into its middle
+		for(auto it = m_blockStarts.rbegin(); it != m_blockStarts.rend(); ++it)
+		{
+			const auto pc = *it;
+
+			// The first block of a loop body is created when the loop is running as its generation verifies the state of the loop
+			if(m_loopBodyStarts.find(pc) != m_loopBodyStarts.end())
+				continue;
+
+			// Same for the last one, it terminates at the loop end, see JitPersistentCache
+			if(m_loopBodyEnds.find(pc) != m_loopBodyEnds.end())
+				continue;
+
+			if(chain->getBlock(pc))
+				continue;
+
+			chain->create(pc, false);
+
+			if(chain->getBlock(pc))
+				++count;
+		}
+
+		LOG("AOT: Compiled " << count << " of " << m_blockStarts.size() << " blocks");
+
+		return count;
+	}
+}
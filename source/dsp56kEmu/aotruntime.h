@@ -0,0 +1,47 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "types.h"
+
+namespace dsp56k
+{
+	class DSP;
+
+	// Ahead-of-time compilation of a firmware image that is present in P memory. All code that is statically reachable
+	// from the interrupt vectors, the current PC and any additional entry points is analyzed and compiled before the
+	// DSP starts running it, which removes the JIT warm-up. Anything that has not been found (computed jumps) or that is
+	// modified at runtime is handled by the JIT as usual.
+	// This runs in-process on top of the JIT, it does not emit native objects or C++ sources offline. Generated code
+	// refers to the DSP instance by absolute address and cannot be relocated into an object file.
+	class AotRuntime
+	{
+	public:
+		explicit AotRuntime(DSP& _dsp);
+
+		void addEntryPoint(TWord _pc);
+
+		// returns the number of block entry points that have been found
+		size_t analyze();
+
+		// returns the number of blocks that have been compiled
+		size_t compile();
+
+		const std::set<TWord>& getBlockStarts() const { return m_blockStarts; }
+		const std::map<TWord, TWord>& getLoops() const { return m_loops; }
+
+	private:
+		void walk(TWord _pc);
+
+		DSP& m_dsp;
+
+		std::vector<TWord> m_entryPoints;
+		std::set<TWord> m_visited;
+		std::set<TWord> m_blockStarts;
+		std::set<TWord> m_loopBodyStarts;
+		std::set<TWord> m_loopBodyEnds;
+		std::map<TWord, TWord> m_loops;		// DO instruction address => loop end address (LA+1)
+	};
+}
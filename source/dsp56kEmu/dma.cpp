@@ -75,6 +75,7 @@ namespace dsp56k
 				m_pendingTransfer = std::max(1, static_cast<int32_t>((m_dco + 1) << 1)); 
 //				m_pendingTransfer = 1;
 				m_lastClock = m_peripherals.getDSP().getInstructionCounter();
+				m_peripherals.getDSP().schedulePeripheralsEvent(m_pendingTransfer);
 			}
 		}
 		else
@@ -153,6 +154,17 @@ namespace dsp56k
 		}
 */	}
 
+	uint32_t DmaChannel::getInstructionsUntilNextEvent() const
+	{
+		if constexpr (!g_delayedDmaTransfer)
+			return DSP::PeripheralsNoEvent;
+
+		if(m_pendingTransfer <= 0)
+			return DSP::PeripheralsNoEvent;
+
+		return static_cast<uint32_t>(m_pendingTransfer);
+	}
+
 	void DmaChannel::triggerByRequest()
 	{
 		execTransfer();
@@ -535,6 +547,19 @@ namespace dsp56k
 		m_channels[5].exec();
 	}
 
+	uint32_t Dma::getInstructionsUntilNextEvent() const
+	{
+		if((m_dstr & (1 << Dact)) == 0)
+			return DSP::PeripheralsNoEvent;
+
+		uint32_t delay = DSP::PeripheralsNoEvent;
+
+		for (const auto& c : m_channels)
+			delay = std::min(delay, c.getInstructionsUntilNextEvent());
+
+		return delay;
+	}
+
 	void Dma::setActiveChannel(const TWord _channel)
 	{
 		m_dstr |= (1 << Dact);
@@ -98,6 +98,7 @@ namespace dsp56k
 		const TWord& getDCR() const;
 
 		void exec();
+		uint32_t getInstructionsUntilNextEvent() const;
 
 		void triggerByRequest();
 
@@ -190,6 +191,7 @@ namespace dsp56k
 		const TWord& getDCR(const TWord _channel) const { return m_channels[_channel].getDCR(); }
 
 		void exec();
+		uint32_t getInstructionsUntilNextEvent() const;
 		void setActiveChannel(TWord _channel);
 		void clearActiveChannel();
 
@@ -2,6 +2,7 @@
 
 #include "dsp.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <cstring>
 
@@ -13,6 +14,8 @@
 #include "debuggerinterface.h"
 #include "dspconfig.h"
 #include "interrupts.h"
+#include "jitblockruntimedata.h"
+#include "opcodeanalysis.h"
 
 #include "dsp_decode.inl"
 
@@ -148,7 +151,7 @@ namespace dsp56k
 		// we do not support 16-bit compatibility mode
 		assert( (reg.sr.var & SR_SC) == 0 && "16 bit compatibility mode is not supported");
 
-		if(g_useJIT)
+		if(runsJitBlocks())
 		{
 #if 0
 			if(m_processingMode == Default)
@@ -208,13 +211,42 @@ namespace dsp56k
 	{
 		const auto diff = getRemainingPeripheralsCycles();
 
-		if (diff > 0 && diff < PeripheralsProcessingStepSize)
+		if(m_eventDrivenPeripherals)
+		{
+			if (diff > 0 && diff <= PeripheralsMaxProcessingStepSize)
+				return;
+
+			perif[0]->exec();
+			perif[1]->exec();
+
+			const auto delay = std::min(perif[0]->getInstructionsUntilNextEvent(), perif[1]->getInstructionsUntilNextEvent());
+			m_peripheralCounter = m_instructions + std::clamp(delay, 1u, PeripheralsMaxProcessingStepSize);
+		}
+		else
+		{
+			if (diff > 0 && diff < PeripheralsProcessingStepSize)
+				return;
+
+			m_peripheralCounter += PeripheralsProcessingStepSize;
+
+			perif[0]->exec();
+			perif[1]->exec();
+		}
+
+		if(runsJitBlocks())
+			m_jit.onPeripheralStep();
+	}
+
+	void DSP::schedulePeripheralsEvent(const uint32_t _delay)
+	{
+		if(!m_eventDrivenPeripherals)
 			return;
 
-		m_peripheralCounter += PeripheralsProcessingStepSize;
+		// a peripheral got work to do earlier than the currently scheduled step, a step that is already due stays due
+		const auto remaining = static_cast<int32_t>(getRemainingPeripheralsCycles());
 
-		perif[0]->exec();
-		perif[1]->exec();
+		if(remaining > 0 && static_cast<uint32_t>(remaining) > _delay)
+			m_peripheralCounter = m_instructions + std::max(_delay, 1u);
 	}
 
 	void DSP::tryExecInterrupts()
@@ -243,7 +275,8 @@ namespace dsp56k
 			m_debugger->onExec(vba);
 #endif
 
-		if(g_useJIT)
+		// closure blocks run the interpreter ops, fast interrupts are processed by the interpreter as well
+		if(g_useJIT && m_useJit && !m_jit.getConfig().closureBlocks)
 		{
 			m_jit.exec(vba);
 			if(m_processingMode != LongInterrupt)
@@ -305,6 +338,9 @@ namespace dsp56k
 				m_processingMode = DefaultPreventInterrupt;
 				m_interruptFunc = &dspExecDefaultPreventInterrupt;
 			}
+
+			if(runsJitBlocks())
+				m_jit.checkModeChange();
 		}
 	}
 
@@ -367,7 +403,14 @@ namespace dsp56k
 		m_currentOpLen = 1;
 
 		const TWord currentOp = pcCurrentInstruction;
-		const auto& opCache = m_opcodeCache[currentOp];
+		auto& opCache = m_opcodeCache[currentOp];
+
+		// P memory can change without a call to notifyProgramMemWrite (raw memory pointers, AAR changes), resolve again if the word is no longer the same
+		if(opCache.opWord != op)
+		{
+			opCache.opWord = op;
+			opCache.op = &DSP::op_ResolveCache;
+		}
 
 		exec_jump(opCache.op, op);
 
@@ -380,6 +423,101 @@ namespace dsp56k
 		}
 	}
 
+	void DSP::execInterpreted(const TWord _pc)
+	{
+		// Runs a single instruction via the interpreter while the JIT is in use. The JIT expects a fully updated SR
+		// and handles loop ends at the end of a block, so both need to be emulated here
+		pcCurrentInstruction = _pc;
+		setPC(_pc);
+
+		const auto op = fetchPC();
+
+		execOp(op);
+
+		updateDirtyCCR();
+
+		if(!sr_test_noCache(SR_LF))
+			return;
+
+		const auto la = static_cast<TWord>(reg.la.var);
+
+		if(static_cast<TWord>(reg.pc.var) != la + 1 || _pc > la)
+			return;
+
+		if(reg.lc.var <= 1)
+		{
+			do_end();
+		}
+		else
+		{
+			--reg.lc.var;
+			setPC(hiword(reg.ss[ssIndex()]));
+		}
+	}
+
+	void DSP::execClosures(const JitClosure* _begin, const JitClosure* _end)
+	{
+		// Runs a block of closures, see JitConfig::closureBlocks. Like execInterpreted, loop ends are handled here as
+		// do_exec does not run the loop body recursively. The block is left as soon as an op does not continue with the
+		// next closure. An op that writes to P memory is the last one of its block and might have destroyed it already
+		for(auto* c = _begin; c != _end; ++c)
+		{
+			const auto pc = c->pc;
+			const auto pcNext = pc + c->len;
+
+			pcCurrentInstruction = pc;
+			setPC(pc + 1);
+			m_opWordB = c->opB;
+			m_currentOpLen = 1;
+
+			exec_jump(c->func, c->op);
+
+			if(pcCurrentInstruction == pc)
+				++m_instructions;
+
+			if(sr_test_noCache(SR_LF))
+			{
+				const auto la = static_cast<TWord>(reg.la.var);
+
+				if(static_cast<TWord>(reg.pc.var) == la + 1 && pc <= la)
+				{
+					if(reg.lc.var <= 1)
+					{
+						do_end();
+					}
+					else
+					{
+						--reg.lc.var;
+						setPC(hiword(reg.ss[ssIndex()]));
+					}
+					return;
+				}
+			}
+
+			if(static_cast<TWord>(reg.pc.var) != pcNext)
+				return;
+		}
+	}
+
+	TInstructionFunc DSP::resolveOpcode(const TWord _pc, const TWord _op)
+	{
+		auto& opCache = m_opcodeCache[_pc];
+
+		if(opCache.opWord != _op || opCache.op == &DSP::op_ResolveCache)
+		{
+			opCache.opWord = _op;
+			resolveOpcodeCache(opCache, _op);
+		}
+
+		return opCache.op;
+	}
+
+	bool DSP::runsJitBlocks() const
+	{
+		// closure blocks do not need JIT support of the host
+		return (g_useJIT || m_jit.getConfig().closureBlocks) && m_useJit;
+	}
+
 	void DSP::exec_jump(const TInstructionFunc& _func, TWord _op)
 	{
 		(this->*_func)(_op);
@@ -539,6 +677,10 @@ namespace dsp56k
 		
 		sr_set( SR_LF );
 
+		// blocks handle the loop end themselves, the op is counted by the caller
+		if(runsJitBlocks())
+			return true;
+
 		++m_instructions;
 
 		traceOp();
@@ -19,6 +19,7 @@ namespace dsp56k
 	class JitOps;
 	class AotRuntime;
 	class DebuggerInterface;
+	struct JitClosure;
 	
 	using TInstructionFunc = void (DSP::*)(TWord _op);
 
@@ -29,6 +30,7 @@ namespace dsp56k
 		friend class UnitTests;
 		friend class JitDspRegs;
 		friend class JitOps;
+		friend class JitMacLoop;
 		friend class Jit;
 		friend class AotRuntime;
 		friend class DebuggerInterface;
@@ -110,6 +112,8 @@ namespace dsp56k
 		typedef void (*TInterruptFunc)(DSP*);
 
 		static constexpr uint32_t PeripheralsProcessingStepSize = 32;
+		static constexpr uint32_t PeripheralsMaxProcessingStepSize = 512;	// upper bound of the distance between two steps if peripherals are event driven, limits the latency of input from other threads
+		static constexpr uint32_t PeripheralsNoEvent = 0xffffffff;
 
 	private:
 		// _____________________________________________________________________________
@@ -118,6 +122,8 @@ namespace dsp56k
 		Memory&							mem;
 		std::array<IPeripherals*, 2>	perif;
 		uint32_t						m_peripheralCounter = 0;
+		bool							m_eventDrivenPeripherals = false;
+		bool							m_useJit = true;
 		
 		TWord							pcCurrentInstruction = 0;
 		TWord							m_opWordB = 0;
@@ -142,6 +148,9 @@ namespace dsp56k
 			TInstructionFunc op;
 			TInstructionFunc opMove;
 			TInstructionFunc opAlu;
+
+			// opcode word that the handlers have been resolved for
+			TWord opWord = 0;
 		};
 
 		std::vector<OpcodeCacheEntry>	m_opcodeCache;
@@ -202,6 +211,13 @@ namespace dsp56k
 
 		uint32_t	getRemainingPeripheralsCycles() const	{ return m_peripheralCounter - m_instructions; }
 
+		// Process peripherals at the earliest time one of them needs to act instead of every PeripheralsProcessingStepSize instructions
+		void	setEventDrivenPeripherals		(const bool _enable)						{ m_eventDrivenPeripherals = _enable; }
+		void	schedulePeripheralsEvent		(uint32_t _delay);
+
+		// Runs the interpreter even if the JIT is supported, the JIT unit tests use it as reference
+		void	setUseJit						(const bool _useJit)						{ m_useJit = _useJit; }
+
 		bool	readReg							( EReg _reg, TReg8& _res ) const;
 		bool	readReg							( EReg _reg, TReg48& _res ) const;
 		bool	readReg							( EReg _reg, TReg5& _res ) const;
@@ -300,6 +316,11 @@ namespace dsp56k
 		}
 
 		void 	execOp							(TWord op);
+		void	execInterpreted					(TWord _pc);
+		void	execClosures					(const JitClosure* _begin, const JitClosure* _end);
+		bool	runsJitBlocks					() const;
+
+		TInstructionFunc	resolveOpcode		(TWord _pc, TWord _op);
 
 		void	exec_jump						(const TInstructionFunc& _func, TWord _op);
 		
@@ -976,7 +997,9 @@ namespace dsp56k
 		void op_Vsl(TWord op);
 		void op_Wait(TWord op);
 		void op_ResolveCache(TWord op);
+		void resolveOpcodeCache(OpcodeCacheEntry& _entry, TWord _op);
 		void op_Parallel(TWord op);
+		void op_ParallelNoLatch(TWord op);
 
 		// ------------- function permutations -------------
 		static TInstructionFunc resolvePermutation(Instruction _inst, TWord _op);
@@ -510,13 +510,18 @@ namespace dsp56k
 	inline void DSP::op_ResolveCache(const TWord op)
 	{
 		auto& cacheEntry = m_opcodeCache[pcCurrentInstruction];
+
+		resolveOpcodeCache(cacheEntry, op);
+
+		exec_jump(cacheEntry.op, op);
+	}
+
+	inline void DSP::resolveOpcodeCache(OpcodeCacheEntry& cacheEntry, const TWord op)
+	{
 		cacheEntry.op = &DSP::op_Nop;
 
 		if( !op )
-		{
-			op_Nop(0);
 			return;
-		}
 
 		if(Opcodes::isNonParallelOpcode(op))
 		{
@@ -529,8 +534,6 @@ namespace dsp56k
 			}
 
 			cacheEntry.op = resolvePermutation(oi->m_instruction, op);
-
-			exec_jump(cacheEntry.op, op);
 			return;
 		}
 		const auto* oiMove = m_opcodes.findParallelMoveOpcodeInfo(op);
@@ -557,14 +560,7 @@ namespace dsp56k
 		case Move_Nop:
 			// Only ALU, no parallel move
 			if(oiAlu)
-			{
 				cacheEntry.op = resolvePermutation(oiAlu->m_instruction, op);
-				exec_jump(cacheEntry.op, op);
-			}
-			else
-			{
-				op_Nop(op);
-			}
 			break;
 		case Ifcc:
 		case Ifcc_U:
@@ -574,11 +570,6 @@ namespace dsp56k
 				const auto ifccFunc = resolvePermutation(oiMove->m_instruction, op);
 				cacheEntry.op = ifccFunc;
 				cacheEntry.opAlu = resolvePermutation(oiAlu->m_instruction, op);
-				exec_jump(cacheEntry.op, op);
-			}
-			else
-			{
-				op_Nop(op);						
 			}
 			break;
 		default:
@@ -586,15 +577,27 @@ namespace dsp56k
 			{
 				// if there is no ALU instruction, do only the move
 				cacheEntry.op = resolvePermutation(oiMove->m_instruction, op);
-				exec_jump(cacheEntry.op, op);
 			}
 			else
 			{
-				// call special function that simulates latch registers for alu op + parallel move
-				cacheEntry.op = &DSP::op_Parallel;
 				cacheEntry.opMove = resolvePermutation(oiMove->m_instruction, op);
 				cacheEntry.opAlu = resolvePermutation(oiAlu->m_instruction, op);
-				op_Parallel(op);
+
+				// The ALU op only writes A or B. If the move does not access them, no latch registers need to be simulated,
+				// the ALU op runs first to see the source registers before the move overwrites them
+				auto written = RegisterMask::None;
+				auto read = RegisterMask::None;
+				getRegisters(written, read, oiMove->m_instruction, op);
+
+				if(any(written | read, RegisterMask::AB))
+				{
+					// call special function that simulates latch registers for alu op + parallel move
+					cacheEntry.op = &DSP::op_Parallel;
+				}
+				else
+				{
+					cacheEntry.op = &DSP::op_ParallelNoLatch;
+				}
 			}
 		}
 	}
@@ -607,4 +610,12 @@ namespace dsp56k
 
 		exec_parallel(instMove, instAlu, op);
 	}
+
+	inline void DSP::op_ParallelNoLatch(const TWord op)
+	{
+		const auto& cacheEntry = m_opcodeCache[pcCurrentInstruction];
+
+		exec_jump(cacheEntry.opAlu, op);
+		exec_jump(cacheEntry.opMove, op);
+	}
 }
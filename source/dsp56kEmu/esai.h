@@ -267,6 +267,7 @@ namespace dsp56k
 		void exec();
 		
 		TWord readStatusRegister();
+		const TWord& getStatusRegister() const	{ return m_sr; }	// does not count as status read
 
 		void writestatusRegister(TWord _val)
 		{
@@ -274,22 +275,22 @@ namespace dsp56k
 			m_sr = _val;
 		}
 
-		TWord readReceiveControlRegister() const
+		const TWord& readReceiveControlRegister() const
 		{
 			return m_rcr;
 		}
 		
-		TWord readReceiveClockControlRegister() const
+		const TWord& readReceiveClockControlRegister() const
 		{
 			return m_rccr;
 		}
 		
-		TWord readTransmitControlRegister() const
+		const TWord& readTransmitControlRegister() const
 		{
 			return m_tcr;
 		}
 
-		TWord readTransmitClockControlRegister() const
+		const TWord& readTransmitClockControlRegister() const
 		{
 			return m_tccr;
 		}
@@ -330,12 +331,12 @@ namespace dsp56k
 
 		void terminate();
 
-		TWord readTSMA() const
+		const TWord& readTSMA() const
 		{
 			return m_tsma;
 		}
 
-		TWord readTSMB() const
+		const TWord& readTSMB() const
 		{
 			return m_tsmb;
 		}
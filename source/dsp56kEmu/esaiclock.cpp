@@ -34,6 +34,18 @@ namespace dsp56k
 		}
 	}
 
+	uint32_t EsaiClock::getInstructionsUntilNextEvent() const
+	{
+		if(m_esais.empty())
+			return DSP::PeripheralsNoEvent;
+
+		// the next sample
+		if(m_cyclesSinceWrite >= m_cyclesPerSample)
+			return 1;
+
+		return m_cyclesPerSample - m_cyclesSinceWrite;
+	}
+
 	void EsaiClock::setPCTL(TWord _val)
 	{
 		if(m_pctl == _val)
@@ -14,6 +14,7 @@ namespace dsp56k
 	public:
 		EsaiClock(IPeripherals& _peripherals) : m_periph(_peripherals) {}
 		void exec();
+		uint32_t getInstructionsUntilNextEvent() const;
 
 		void setPCTL(TWord _val);
 		TWord getPCTL() const { return m_pctl; }
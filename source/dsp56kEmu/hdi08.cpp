@@ -75,6 +75,28 @@ namespace dsp56k
 		}
 	}
 
+	uint32_t HDI08::getInstructionsUntilNextEvent() const
+	{
+		if (!bittest(m_hpcr, HPCR_HEN))
+			return DSP::PeripheralsNoEvent;
+
+		if (!m_dataRX.empty())
+		{
+			if (m_waitServeRXInterrupt || !rxInterruptEnabled())
+				return DSP::PeripheralsProcessingStepSize;
+
+			const auto d = delta(m_periph.getDSP().getInstructionCounter(), m_lastRXClock);
+			return d >= m_rxRateLimit ? 1 : m_rxRateLimit - d;
+		}
+
+		// data written by the host is picked up at the latest after DSP::PeripheralsMaxProcessingStepSize instructions
+		const auto txIdle = m_transmitDataAlwaysEmpty
+			? (!txInterruptEnabled() || m_pendingTXInterrupts == 0)
+			: (m_dataTX.empty() && bittest(m_hsr, HSR_HTDE));
+
+		return txIdle ? DSP::PeripheralsNoEvent : DSP::PeripheralsProcessingStepSize;
+	}
+
 	TWord HDI08::readRX(Instruction _inst)
 	{
 		if (m_dataRX.empty())
@@ -185,7 +207,7 @@ namespace dsp56k
 			m_dataRX.push_back(0);
 	}
 
-	TWord HDI08::readHDR() const
+	const TWord& HDI08::readHDR() const
 	{
 //		LOG("Read HDR: " << HEX(m_hdr));
 		return m_hdr;
@@ -283,6 +305,8 @@ namespace dsp56k
 		if(m_transmitDataAlwaysEmpty)
 			injectTXInterrupt();
 
+		m_periph.getDSP().schedulePeripheralsEvent(DSP::PeripheralsProcessingStepSize);
+
 		if(m_callbackTx)
 			m_callbackTx();
 	}
@@ -297,6 +321,9 @@ namespace dsp56k
 		const auto hasTXInterrupt = txInterruptEnabled();
 		const auto hasRXInterrupt = rxInterruptEnabled();
 
+		if((!hadTXInterrupt && hasTXInterrupt) || (!hadRXInterrupt && hasRXInterrupt))
+			m_periph.getDSP().schedulePeripheralsEvent(DSP::PeripheralsProcessingStepSize);
+
 		if(!hadTXInterrupt && hasTXInterrupt && dsp56k::bittest<TWord, HSR_HTDE>(m_hsr))
 		{
 			if(m_transmitDataAlwaysEmpty)
@@ -61,13 +61,14 @@ namespace dsp56k
 		using CallbackTx = std::function<void()>;
 
 		TWord readStatusRegister();
+		const TWord& getStatusRegister() const { return m_hsr; }	// not updated, call readStatusRegister() first
 
-		TWord readControlRegister() const
+		const TWord& readControlRegister() const
 		{
 			return m_hcr;
 		}
 
-		TWord readPortControlRegister() const
+		const TWord& readPortControlRegister() const
 		{
 			return m_hpcr;
 		}
@@ -91,6 +92,7 @@ namespace dsp56k
 		void writeTX(TWord _val);
 
 		void exec();
+		uint32_t getInstructionsUntilNextEvent() const;
 
 		TWord readRX(Instruction _inst);
 
@@ -112,7 +114,7 @@ namespace dsp56k
 
 		void terminate();
 
-		TWord readHDR() const;
+		const TWord& readHDR() const;
 		void writeHDR(TWord _val);
 
 		TWord readHDDR() const;
@@ -30,6 +30,8 @@ namespace dsp56k
 		testEXTRACTU();
 		testEXTRACTU_CO();
 		testMPY();
+		testDirectPMemWrite();
+		testParallelMoveLatch();
 		
 		runAllTests();
 	}
@@ -583,6 +585,85 @@ namespace dsp56k
 		verify(dsp.reg.a.var == 0x0000b37a000000);
 	}
 
+	void InterpreterUnitTests::testDirectPMemWrite()
+	{
+		// move #$ff,r2
+		execOpcode(0x32ff00, 0, false, 0x10);
+		verify(dsp.reg.r[2].var == 0xff);
+
+		// P memory modified without notifying the DSP needs to be picked up, too
+
+		// move #$10,r2
+		dsp.mem.getMemAreaPtr(MemArea_P)[0x10] = 0x321000;
+		dsp.setPC(0x10);
+		dsp.exec();
+		verify(dsp.reg.r[2].var == 0x10);
+
+		// move #$20,r3
+		dsp.mem.getMemAreaPtr(MemArea_P)[0x10] = 0x332000;
+		dsp.setPC(0x10);
+		dsp.exec();
+		verify(dsp.reg.r[3].var == 0x20);
+		verify(dsp.reg.r[2].var == 0x10);
+
+		// the same for both words of a fast interrupt, which are not fetched via the PC
+		auto* p = dsp.mem.getMemAreaPtr(MemArea_P);
+
+		auto execFastInterrupt = [&](const TWord _op0, const TWord _op1)
+		{
+			p[0x20] = _op0;
+			p[0x21] = _op1;
+			dsp.injectInterrupt(0x20);
+
+			// the second exec leaves the state after the fast interrupt that prevents the next one
+			for(size_t i=0; i<2; ++i)
+			{
+				dsp.setPC(0x10);
+				dsp.exec();
+			}
+		};
+
+		// clr a / nop
+		dsp.reg.a.var = 0x1234;
+		execFastInterrupt(0x200013, 0x000000);
+		verify(dsp.reg.a.var == 0);
+
+		// move #$30,r4 / move #$40,r5
+		execFastInterrupt(0x343000, 0x354000);
+		verify(dsp.reg.r[4].var == 0x30);
+		verify(dsp.reg.r[5].var == 0x40);
+	}
+
+	void InterpreterUnitTests::testParallelMoveLatch()
+	{
+		// the move does not access A or B, the ALU op needs to use the values of x0 and y0 before the move replaces them
+		dsp.memory().set(MemArea_X, 0, 0x100000);
+		dsp.memory().set(MemArea_Y, 0, 0x080000);
+		dsp.reg.a.var = 0;
+		dsp.x0(TWord(0x400000));
+		dsp.y0(TWord(0x200000));
+		dsp.reg.r[0].var = 0;
+		dsp.reg.r[4].var = 0;
+		dsp.reg.m[0].var = 0xffffff;
+		dsp.reg.m[4].var = 0xffffff;
+
+		// mac y0,x0,a x:(r0)+,x0 y:(r4)+,y0
+		execOpcode(0xf098d2);
+		verify(dsp.reg.a.var == 0x00100000000000);
+		verify(dsp.x0().var == 0x100000);
+		verify(dsp.y0().var == 0x080000);
+		verify(dsp.reg.r[0].var == 1);
+		verify(dsp.reg.r[4].var == 1);
+
+		// the move reads A, it needs to see A before the ALU op has modified it
+		dsp.reg.r[0].var = 0;
+
+		// add x0,a a,x:(r0)+
+		execOpcode(0x565840);
+		verify(dsp.reg.a.var == 0x00200000000000);
+		verify(dsp.memory().get(MemArea_X, 0) == 0x100000);
+	}
+
 	void InterpreterUnitTests::runTest(const std::function<void()>& _build, const std::function<void()>& _verify)
 	{
 		_build();
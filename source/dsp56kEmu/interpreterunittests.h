@@ -34,6 +34,8 @@ namespace dsp56k
 		void testEXTRACTU();
 		void testEXTRACTU_CO();
 		void testMPY();
+		void testDirectPMemWrite();
+		void testParallelMoveLatch();
 
 		void runTest(const std::function<void()>& _build, const std::function<void()>& _verify) override;
 		void emit(TWord _opA, TWord _opB, TWord _pc = 0) override;
@@ -1,19 +1,32 @@
 #include "jit.h"
 
 #include "dsp.h"
+#include "interrupts.h"
 #include "jitblock.h"
+#include "jitblockruntimedata.h"
+#include "jitcoderepository.h"
 #include "jitdspmode.h"
+#include "jitpersistentcache.h"
 #include "jitprofilingsupport.h"
 #include "jitblockemitter.h"
 
 #include "asmjit/core/jitruntime.h"
 
+#include <algorithm>	// std::sort
+#include <mutex>
+
 using namespace asmjit;
 
 namespace dsp56k
 {
 	constexpr bool g_traceOps = false;
 
+	// JIT runtime that is shared by all instances that have JitConfig::shareJitRuntime enabled. Packing the code of
+	// all instances into the same memory blocks reduces the number of partially used code pages
+	static std::mutex g_sharedRuntimeMutex;
+	static JitRuntime* g_sharedRuntime = nullptr;
+	static uint32_t g_sharedRuntimeRefCount = 0;
+
 	void funcCreate(Jit* _jit, const TWord _pc)
 	{
 		_jit->create(_pc, true);
@@ -44,11 +57,33 @@ namespace dsp56k
 		_jit->run(_pc);
 	}
 
-	Jit::Jit(DSP& _dsp) : m_dsp(_dsp), m_rt(new JitRuntime())
+	void funcInterpret(Jit* _jit, const TWord _pc)
+	{
+		_jit->interpret(_pc);
+	}
+
+	void funcRunShared(Jit* _jit, const TWord _pc)
+	{
+		_jit->execShared(_pc);
+	}
+
+	void funcRunClosures(Jit* _jit, const TWord _pc)
+	{
+		_jit->runClosures(_pc);
+	}
+
+	Jit::Jit(DSP& _dsp) : m_dsp(_dsp)
 	{
 		m_emitters.reserve(16);
 		m_blockRuntimeDatas.reserve(0x10000);
 
+		const auto pSize = m_dsp.memory().sizeP();
+
+		m_volatileP.resize(pSize, false);
+		m_compiledPPages.resize((pSize >> PPageShift) + 1, 0);
+		m_aguGuardFailed.resize(pSize, false);
+		m_privateP.resize(pSize, false);
+
 		if (JitProfilingSupport::isBeingProfiled())
 			m_profiling.reset(new JitProfilingSupport(m_dsp));
 	}
@@ -65,7 +100,56 @@ namespace dsp56k
 		m_emitters.clear();
 		m_blockRuntimeDatas.clear();
 
-		delete m_rt;
+		releaseRuntime();
+	}
+
+	JitRuntime* Jit::getRuntime()
+	{
+		if(m_rt)
+			return m_rt;
+
+		m_sharedRuntime = m_config.shareJitRuntime;
+
+		if(!m_sharedRuntime)
+		{
+			m_rt = new JitRuntime();
+			return m_rt;
+		}
+
+		std::lock_guard lock(g_sharedRuntimeMutex);
+
+		if(!g_sharedRuntime)
+			g_sharedRuntime = new JitRuntime();
+
+		++g_sharedRuntimeRefCount;
+
+		m_rt = g_sharedRuntime;
+		return m_rt;
+	}
+
+	void Jit::releaseRuntime()
+	{
+		if(!m_rt)
+			return;
+
+		if(!m_sharedRuntime)
+		{
+			delete m_rt;
+			m_rt = nullptr;
+			return;
+		}
+
+		std::lock_guard lock(g_sharedRuntimeMutex);
+
+		assert(g_sharedRuntimeRefCount > 0);
+
+		if(--g_sharedRuntimeRefCount == 0)
+		{
+			delete g_sharedRuntime;
+			g_sharedRuntime = nullptr;
+		}
+
+		m_rt = nullptr;
 	}
 
 	void Jit::create(TWord _pc, bool _execute)
@@ -130,6 +214,223 @@ namespace dsp56k
 		}
 	}
 
+	bool Jit::canInterpret(const TWord _pc) const
+	{
+		// fast interrupts are processed differently by the interpreter
+		if(_pc < Vba_End)
+			return false;
+
+		// a loop is registered by the block that begins it, the blocks of its body end at the loop end. The analysis is cached per address
+		return (m_dsp.memory().getOpcodeAnalysis(_pc).flags & OpFlagLoop) == 0;
+	}
+
+	void Jit::interpret(const TWord _pc)
+	{
+		++m_statistics.interpretedInstructions;
+
+		if(!m_config.buildSuperblocks)
+		{
+			m_dsp.execInterpreted(_pc);
+			checkModeChange();
+			return;
+		}
+
+		TWord opA, opB;
+		m_dsp.memory().getOpcode(_pc, opA, opB);
+
+		Instruction instA, instB;
+		m_dsp.opcodes().getInstructionTypes(opA, instA, instB);
+
+		const auto pcFallthrough = _pc + m_dsp.opcodes().getOpcodeLength(opA, instA, instB);
+
+		m_dsp.execInterpreted(_pc);
+
+		if(JitBranchProfile::isConditionalBranch(instA, instB))
+			m_branchProfile.add(_pc, m_dsp.getPC().toWord() != pcFallthrough);
+
+		checkModeChange();
+	}
+
+	void Jit::createClosures(std::vector<JitClosure>& _closures, const JitBlockInfo& _info)
+	{
+		const auto& mem = m_dsp.memory();
+		const auto pcEnd = _info.pc + _info.memSize;
+
+		for(auto pc = _info.pc; pc < pcEnd;)
+		{
+			const auto& analysis = mem.getOpcodeAnalysis(pc);
+
+			JitClosure c;
+
+			c.func = m_dsp.resolveOpcode(pc, analysis.opA);
+			c.pc = pc;
+			c.op = analysis.opA;
+			c.opB = analysis.opB;
+			c.len = analysis.length;
+
+			// the interpreter runs the repeated op as part of the REP
+			if(analysis.flags & (OpFlagRepDynamic | OpFlagRepImmediate))
+				c.len += mem.getOpcodeAnalysis(pc + c.len).length;
+
+			_closures.push_back(c);
+
+			pc += c.len;
+		}
+	}
+
+	std::shared_ptr<const JitClosures> Jit::shareClosures(const JitDspMode& _mode, const JitBlockInfo& _info, JitClosures&& _closures, bool& _shared)
+	{
+		_shared = false;
+
+		if(!m_config.shareClosureBlocks)
+			return std::make_shared<const JitClosures>(std::move(_closures));
+
+		for(TWord i=0; i<_info.memSize; ++i)
+		{
+			if(m_privateP[_info.pc + i])
+				return std::make_shared<const JitClosures>(std::move(_closures));
+		}
+
+		// the closures have been created anyway as the handlers of parallel moves are looked up in the opcode cache of the running instance
+		bool found;
+		auto closures = JitCodeRepository::share(_mode.get(), JitPersistentCache::calcConfigHash(m_config), std::move(_closures), found);
+
+		if(found)
+			++m_statistics.sharedClosureBlocks;
+
+		_shared = true;
+		return closures;
+	}
+
+	bool Jit::runsSharedClosures(const TWord _pc) const
+	{
+		for (const auto& it : m_chains)
+		{
+			const auto* block = it.second->getBlock(_pc);
+
+			if(block && block->hasSharedClosures())
+				return true;
+		}
+		return false;
+	}
+
+	void Jit::runClosures(const TWord _pc)
+	{
+		// a mode chain forwards to the shared chain if it does not own the block itself
+		const auto* block = m_currentChain->getBlock(_pc);
+
+		if(!block || block->getPCFirst() != _pc)
+			block = m_sharedChain->getBlock(_pc);
+
+		const auto& closures = block->getClosures();
+
+		m_dsp.execClosures(closures.data(), closures.data() + closures.size());
+	}
+
+	void Jit::enqueueCompile(const JitDspMode& _mode, const TWord _pc)
+	{
+		m_compileQueue.emplace_back(_mode, _pc);
+	}
+
+	void Jit::compileQueuedBlocks()
+	{
+		for(uint32_t i=0; i<m_config.compileQueueBlocksPerStep && !m_compileQueue.empty(); ++i)
+		{
+			const auto [mode, pc] = m_compileQueue.front();
+			m_compileQueue.pop_front();
+
+			getChain(mode)->compileDeferred(pc);
+		}
+	}
+
+	size_t Jit::getCodeSize() const
+	{
+		size_t size = 0;
+
+		for (const auto& it : m_chains)
+			size += it.second->getCodeSize();
+
+		return size;
+	}
+
+	void Jit::checkCodeSize()
+	{
+		// we sample the block that is about to run to track which blocks are in use
+		++m_epoch;
+
+		if(m_currentChain)
+			m_currentChain->touch(m_dsp.getPC().var, m_epoch);
+		if(m_sharedChain)
+			m_sharedChain->touch(m_dsp.getPC().var, m_epoch);
+
+		if(getCodeSize() > m_config.maxCodeSize)
+			evictBlocks();
+	}
+
+	void Jit::evictBlocks()
+	{
+		++m_statistics.evictionRuns;
+
+		// evict more than needed to not run into the next eviction right away
+		const size_t target = m_config.maxCodeSize - (m_config.maxCodeSize >> 2);
+
+		const auto sizeBefore = getCodeSize();
+
+		// cached single-op blocks are not running at all, they go first
+		for (const auto& it : m_chains)
+			m_statistics.evictedBlocks += it.second->clearSingleOpCache();
+
+		auto size = getCodeSize();
+
+		if(size > target)
+		{
+			const auto pSize = m_dsp.memory().sizeP();
+
+			m_evictionCandidates.clear();
+
+			for (const auto& it : m_chains)
+			{
+				auto* chain = it.second.get();
+
+				for(TWord pc=0; pc<pSize; ++pc)
+				{
+					const auto* b = chain->getBlock(pc);
+
+					// blocks that begin a DO loop are kept as they register the loop that subsequent blocks depend on
+					if(!b || b->getPCFirst() != pc || b->getInfo().loopBegin != g_invalidAddress)
+						continue;
+
+					m_evictionCandidates.push_back({chain, pc, b->getLastUsed()});
+				}
+			}
+
+			std::sort(m_evictionCandidates.begin(), m_evictionCandidates.end(), [](const EvictionCandidate& _a, const EvictionCandidate& _b)
+			{
+				return _a.lastUsed < _b.lastUsed;
+			});
+
+			for (const auto& c : m_evictionCandidates)
+			{
+				if(size <= target)
+					break;
+
+				// the block might be gone already if it has been a parent of a previously evicted block
+				const auto chainSize = c.chain->getCodeSize();
+
+				if(!c.chain->evict(c.pc))
+					continue;
+
+				++m_statistics.evictedBlocks;
+				size -= chainSize - c.chain->getCodeSize();
+			}
+		}
+
+		size = getCodeSize();
+
+		if(sizeBefore > size)
+			m_statistics.evictedBytes += sizeBefore - size;
+	}
+
 	void Jit::emit(const TWord _pc)
 	{
 		auto* b = m_currentChain->emit(_pc);
@@ -139,7 +440,33 @@ namespace dsp56k
 
 	void Jit::notifyProgramMemWrite(const TWord _offset)
 	{
-		destroy(_offset);
+		// the new code might not depend on the mode anymore
+		if(m_sharedChain)
+			m_sharedChain->resetModeDependency(_offset);
+
+		// new code gets another chance to be specialized
+		m_aguGuardFailed[_offset] = false;
+
+		// nothing to invalidate if no chain has code in this page, which is the common case for data that is streamed into P memory
+		if(hasCompiledP(_offset))
+		{
+			// self-modifying code continues with private blocks, other instances keep running the shared ones
+			if(m_config.shareClosureBlocks && !m_privateP[_offset] && runsSharedClosures(_offset))
+			{
+				m_privateP[_offset] = true;
+				++m_statistics.privateClosureBlocks;
+			}
+
+			destroy(_offset);
+		}
+	}
+
+	void Jit::onAguGuardFailed(const TWord _pc)
+	{
+		// the block did not execute anything, run it again after it has been recreated
+		m_aguGuardFailed[_pc] = true;
+		m_dsp.setPC(_pc);
+		++m_statistics.aguGuardFailures;
 	}
 
 	void Jit::run(const TWord _pc)
@@ -213,12 +540,15 @@ namespace dsp56k
 		if (pMemWriteAddr == g_pcInvalid)
 			return;
 
-		for (const auto& it : m_chains)
+		if(hasCompiledP(pMemWriteAddr))
 		{
-			if (it.second->getBlock(pMemWriteAddr))
+			for (const auto& it : m_chains)
 			{
-				m_volatileP.insert(pMemWriteAddr);
-				break;
+				if (it.second->getBlock(pMemWriteAddr))
+				{
+					m_volatileP[pMemWriteAddr] = true;
+					break;
+				}
 			}
 		}
 
@@ -237,17 +567,43 @@ namespace dsp56k
 
 //		LOG("DSP mode change to " << HEX(mode.get()));
 
-		const auto itExisting = m_chains.find(mode);
+		m_currentChain = getChain(mode);
+	}
 
-		if(itExisting == m_chains.end())
+	JitBlockChain* Jit::getChain(const JitDspMode& _mode)
+	{
+		// blocks of the shared chain are stored in the persistent cache with an uninitialized mode
+		if(_mode.get() == JitDspMode::Uninitialized)
 		{
-			m_currentChain = new JitBlockChain(*this, mode);
-			m_chains.insert(std::make_pair(mode, m_currentChain));
+			JitDspMode mode;
+			mode.initialize(dsp());
+			return getSharedChain(mode);
 		}
-		else
+
+		const auto itExisting = m_chains.find(_mode);
+
+		if(itExisting != m_chains.end())
+			return itExisting->second.get();
+
+		auto* chain = new JitBlockChain(*this, _mode);
+		m_chains.insert(std::make_pair(_mode, chain));
+		return chain;
+	}
+
+	JitBlockChain* Jit::getSharedChain(const JitDspMode& _mode)
+	{
+		if(!m_sharedChain)
 		{
-			m_currentChain = itExisting->second.get();
+			// the shared mode is never the mode of a DSP, see JitDspMode::initialize
+			const JitDspMode shared;
+
+			m_sharedChain = new JitBlockChain(*this, shared, true);
+			m_chains.insert(std::make_pair(shared, m_sharedChain));
 		}
+
+		// code is generated for the requesting mode. A block that looks at the mode is not kept in the shared chain
+		m_sharedChain->setCodeMode(_mode);
+		return m_sharedChain;
 	}
 
 	void Jit::onDebuggerAttached(DebuggerInterface& _debugger) const
@@ -273,11 +629,23 @@ namespace dsp56k
 
 	void Jit::destroyAllBlocks()
 	{
+		m_compileQueue.clear();
 		m_chains.clear();
 		m_currentChain = nullptr;
+		m_sharedChain = nullptr;
 		checkModeChange();
 	}
 
+	bool Jit::savePersistentCache(const std::string& _filename)
+	{
+		return JitPersistentCache(*this).save(_filename);
+	}
+
+	bool Jit::loadPersistentCache(const std::string& _filename)
+	{
+		return JitPersistentCache(*this).load(_filename);
+	}
+
 	JitBlockEmitter* Jit::acquireEmitter()
 	{
 		if(m_emitters.empty())
@@ -5,15 +5,19 @@
 #include "jitcacheentry.h"
 #include "types.h"
 
+#include <deque>
+#include <map>
 #include <set>
 #include <vector>
 
 #include "debuggerinterface.h"
 #include "jitblockchain.h"
+#include "jitbranchprofile.h"
 #include "jitconfig.h"
 #include "jitdspmode.h"
 #include "jitemitter.h"
 #include "jitruntimedata.h"
+#include "jitstatistics.h"
 #include "logging.h"
 
 namespace asmjit
@@ -28,6 +32,7 @@ namespace asmjit
 namespace dsp56k
 {
 	struct JitBlockInfo;
+	struct JitClosure;
 	class DSP;
 	class JitBlock;
 	class JitProfilingSupport;
@@ -35,6 +40,9 @@ namespace dsp56k
 
 	class Jit final
 	{
+		friend class AotRuntime;
+		friend class JitPersistentCache;
+
 	public:
 		explicit Jit(DSP& _dsp);
 		~Jit();
@@ -47,6 +55,13 @@ namespace dsp56k
 			m_currentChain->exec(_pc);
 		}
 
+		void execShared(const TWord _pc) const
+		{
+			m_sharedChain->exec(_pc);
+		}
+
+		JitBlockChain* getSharedChain(const JitDspMode& _mode);
+
 		void notifyProgramMemWrite(const TWord _offset);
 
 		void run(TWord _pc);
@@ -62,16 +77,49 @@ namespace dsp56k
 
 		static TJitFunc updateRunFunc(const JitCacheEntry& e);
 
-		auto* getRuntime() { return m_rt; }
+		asmjit::_abi_1_9::JitRuntime* getRuntime();
 		auto& getRuntimeData() { return m_runtimeData; }
 		const auto& getVolatileP()  { return m_volatileP; }
 		auto* getProfilingSupport() const { return m_profiling.get(); }
 
+		const JitStatistics& getStatistics() const { return m_statistics; }
+		JitStatistics& getStatistics() { return m_statistics; }
+		void resetStatistics() { m_statistics = JitStatistics(); }
+
+		const JitBranchProfile& getBranchProfile() const { return m_branchProfile; }
+
 		bool isVolatileP(const TWord _pc) const
 		{
-			return m_volatileP.find(_pc) != m_volatileP.end();
+			return m_volatileP[_pc];
+		}
+
+		// number of P words per page that is tracked for compiled code
+		static constexpr uint32_t PPageShift = 8;
+
+		// called by the block chains for every P address that a block begins or stops to cover
+		void addCompiledP(const TWord _pc)
+		{
+			++m_compiledPPages[_pc >> PPageShift];
+		}
+
+		void removeCompiledP(const TWord _pc)
+		{
+			assert(m_compiledPPages[_pc >> PPageShift] > 0);
+			--m_compiledPPages[_pc >> PPageShift];
+		}
+
+		bool hasCompiledP(const TWord _pc) const
+		{
+			return m_compiledPPages[_pc >> PPageShift] != 0;
+		}
+
+		bool canSpecializeAgu(const TWord _pc) const
+		{
+			return !m_aguGuardFailed[_pc];
 		}
 
+		void onAguGuardFailed(TWord _pc);
+
 		void create(TWord _pc, bool _execute);
 		void recreate(TWord _pc);
 
@@ -82,12 +130,37 @@ namespace dsp56k
 
 		void destroy(TWord _pc);
 
+		bool canInterpret(TWord _pc) const;
+		void interpret(TWord _pc);
+
+		void createClosures(std::vector<JitClosure>& _closures, const JitBlockInfo& _info);
+		std::shared_ptr<const std::vector<JitClosure>> shareClosures(const JitDspMode& _mode, const JitBlockInfo& _info, std::vector<JitClosure>&& _closures, bool& _shared);
+		void runClosures(TWord _pc);
+
+		void enqueueCompile(const JitDspMode& _mode, TWord _pc);
+
+		// called by the DSP at every peripheral processing step, no JIT code is running at this point
+		void onPeripheralStep()
+		{
+			if(!m_compileQueue.empty())
+				compileQueuedBlocks();
+
+			if(m_config.maxCodeSize)
+				checkCodeSize();
+		}
+
+		uint64_t getEpoch() const { return m_epoch; }
+		size_t getCodeSize() const;
+
 		void checkModeChange();
 
 		void onDebuggerAttached(DebuggerInterface& _debugger) const;
 
 		void destroyAllBlocks();
 
+		bool savePersistentCache(const std::string& _filename);
+		bool loadPersistentCache(const std::string& _filename);
+
 		JitBlockEmitter* acquireEmitter();
 		void releaseEmitter(JitBlockEmitter* _emitter);
 
@@ -97,17 +170,32 @@ namespace dsp56k
 	private:
 		void emit(TWord _pc);
 
+		JitBlockChain* getChain(const JitDspMode& _mode);
+
+		void compileQueuedBlocks();
+		void checkCodeSize();
+		void evictBlocks();
+
 		void checkPMemWrite();
 
+		bool runsSharedClosures(TWord _pc) const;
+
+		void releaseRuntime();
+
 		DSP& m_dsp;
 
 		asmjit::_abi_1_9::JitRuntime* m_rt = nullptr;
+		bool m_sharedRuntime = false;
 
 		std::map<JitDspMode, std::unique_ptr<JitBlockChain>> m_chains;
 		JitBlockChain* m_currentChain = nullptr;
+		JitBlockChain* m_sharedChain = nullptr;	// owned by m_chains, stored with an uninitialized mode
 
 		std::vector<TJitFunc> m_jitFuncs;
-		std::set<TWord> m_volatileP;
+		std::vector<bool> m_volatileP;
+		std::vector<uint32_t> m_compiledPPages;		// per page: number of P words that are covered by blocks of any chain
+		std::vector<bool> m_aguGuardFailed;			// blocks starting here did not run with the N and M values they have been specialized for
+		std::vector<bool> m_privateP;				// code that this instance has modified while it ran shared closure blocks, blocks covering it are not shared anymore
 		std::map<TWord, TWord> m_loops;
 		std::set<TWord> m_loopEnds;
 
@@ -116,7 +204,21 @@ namespace dsp56k
 		std::vector<JitBlockEmitter*> m_emitters;
 		std::vector<JitBlockRuntimeData*> m_blockRuntimeDatas;
 
+		std::deque<std::pair<JitDspMode, TWord>> m_compileQueue;
+
+		struct EvictionCandidate
+		{
+			JitBlockChain* chain;
+			TWord pc;
+			uint64_t lastUsed;
+		};
+
+		uint64_t m_epoch = 0;
+		std::vector<EvictionCandidate> m_evictionCandidates;
+
 		JitConfig m_config;
+		JitStatistics m_statistics;
+		JitBranchProfile m_branchProfile;
 
 		// the following data is accessed by JIT code at runtime, it NEEDS to be put last into this struct to be
 		// able to use ARM relative addressing, see member ordering in dsp.h
@@ -5,11 +5,18 @@
 
 #include "jitblockinfo.h"
 #include "jitblockruntimedata.h"
+#include "jitbranchprofile.h"
+#include "jitmacloop.h"
 #include "jitops.h"
 #include "memory.h"
 
 namespace dsp56k
 {
+	void callAguGuardFailed(JitBlockChain* const _chain, const TWord _pc)
+	{
+		_chain->aguGuardFailed(_pc);
+	}
+
 	JitBlock::JitBlock(JitEmitter& _a, DSP& _dsp, JitRuntimeData& _runtimeData, const JitConfig& _config)
 	: m_runtimeData(_runtimeData)
 	, m_asm(_a)
@@ -26,10 +33,8 @@ namespace dsp56k
 
 	JitBlock::~JitBlock() = default;
 
-	void JitBlock::getInfo(JitBlockInfo& _info, const DSP& _dsp, const TWord _pc, const JitConfig& _config, const std::vector<JitCacheEntry>& _cache, const std::set<TWord>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds)
+	void JitBlock::getInfo(JitBlockInfo& _info, const DSP& _dsp, const TWord _pc, const JitConfig& _config, const std::vector<JitCacheEntry>& _cache, const std::vector<bool>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds, const JitBranchProfile* _branchProfile)
 	{
-		const auto& opcodes = _dsp.opcodes();
-
 		const bool isFastInterrupt = _pc < Vba_End;
 
 		const TWord pcMax = isFastInterrupt ? (_pc + 2) : _dsp.memory().sizeP();
@@ -79,23 +84,17 @@ namespace dsp56k
 				break;
 			}
 
-			TWord opA;
-			TWord opB;
-			_dsp.memory().getOpcode(pc, opA, opB);
+			const auto& analysis = _dsp.memory().getOpcodeAnalysis(pc);
 
-			Instruction instA, instB;
+			const auto instA = analysis.instA;
 
-			opcodes.getInstructionTypes(opA, instA, instB);
-
-			auto written = RegisterMask::None;
-			auto read = RegisterMask::None;
-
-			opcodes.getRegisters(written, read, opA, opB);
+			auto written = analysis.written;
+			const auto read = analysis.read;
 
 			const auto writtenM = (written & RegisterMask::M);
 			const auto readM = read & RegisterMask::M;
 
-			const auto flags = Opcodes::getFlags(instA, instB);
+			const auto flags = analysis.flags;
 
 			// a jsr in a fast interrupt modifies the MR because it disables scaling mode bits, loop flag and sixteen-bit arithmetic mode
 			if(isFastInterrupt && (written & RegisterMask::SSL) != RegisterMask::None)
@@ -130,8 +129,8 @@ namespace dsp56k
 			}
 
 			// for a volatile P address, if you have some code, break now. if not, generate this one op, and then return.
-			if (_volatileP.find(pc) != _volatileP.end() || 
-				(_volatileP.find(pc+1) != _volatileP.end() && opcodes.getOpcodeLength(opA, instA, instB) == 2))
+			if (_volatileP[pc] || 
+				(pc + 1 < _volatileP.size() && _volatileP[pc+1] && analysis.length == 2))
 			{
 				terminationReason = JitBlockInfo::TerminationReason::VolatileP;
 				if (numInstructions)
@@ -153,20 +152,35 @@ namespace dsp56k
 			if (writesSR && !readsSR)
 				_info.addFlag(JitBlockInfo::Flags::WritesSRbeforeRead);
 
-			numWords += opcodes.getOpcodeLength(opA);
+			numWords += analysis.length;
 			++numInstructions;
 
-			if(getLoopEndAddr(_info.loopEnd, instA, pc, opB))
+			if(analysis.loopEnd != g_invalidAddress)
+			{
 				_info.loopBegin = pc;
+				_info.loopEnd = analysis.loopEnd;
+			}
 
 			if(!isRep)
 			{
 				if(flags & OpFlagBranch)
 				{
-					terminationReason = JitBlockInfo::TerminationReason::Branch;
-					_info.branchTarget = getBranchTarget(instA, opA, opB, pc);
-					_info.branchIsConditional = hasField(instA, Field_CCCC) || hasField(instA, Field_bbbbb);
-					break;
+					const auto isConditional = hasField(instA, Field_CCCC) || hasField(instA, Field_bbbbb);
+
+					// a conditional branch that is rarely taken does not end the block, a side exit is emitted instead
+					if(isConditional && !isFastInterrupt && _branchProfile && _config.buildSuperblocks && _branchProfile->isRarelyTaken(pc, _config))
+					{
+						_info.addFlag(JitBlockInfo::Flags::HasSideExits);
+					}
+					else
+					{
+						terminationReason = JitBlockInfo::TerminationReason::Branch;
+						_info.branchTarget = analysis.branchTarget;
+						_info.branchIsConditional = isConditional;
+						if(flags & OpFlagPushPC)
+							_info.addFlag(JitBlockInfo::Flags::SubroutineCall);
+						break;
+					}
 				}
 				if(flags & OpFlagPopPC)
 				{
@@ -194,7 +208,7 @@ namespace dsp56k
 				break;
 			}
 
-			if(opcodes.writesToPMemory(opA))
+			if(analysis.writesPMem)
 			{
 				terminationReason = JitBlockInfo::TerminationReason::WritePMem;
 				break;
@@ -215,7 +229,7 @@ namespace dsp56k
 		}
 	}
 
-	bool JitBlock::emit(JitBlockRuntimeData& _rt, JitBlockChain* _chain, const TWord _pc, const std::vector<JitCacheEntry>& _cache, const std::set<TWord>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds, bool _profilingSupport)
+	bool JitBlock::emit(JitBlockRuntimeData& _rt, JitBlockChain* _chain, const TWord _pc, const std::vector<JitCacheEntry>& _cache, const std::vector<bool>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds, const JitBranchProfile* _branchProfile, bool _profilingSupport)
 	{
 		JitBlockGenerating generating(_rt);
 
@@ -227,6 +241,8 @@ namespace dsp56k
 		auto& childAddr = _rt.m_child;
 
 		m_chain = _chain;
+		m_modeDependency = 0;
+		m_specializedAgus = 0;
 
 		const bool isFastInterrupt = _pc < Vba_End;
 
@@ -242,23 +258,112 @@ namespace dsp56k
 		// needed so that the dsp register is available
 		dspRegPool().makeDspPtr(&m_dsp.getInstructionCounter(), sizeof(TWord));
 
-		cursorInsertEncodedInstructionCount = m_asm.cursor();	// inserted later below:	m_mem.mov(temp, getEncodedInstructionCount());
-
 		uint32_t blockFlags = 0;
 
-		getInfo(info, dsp(), _pc, m_config, _cache, _volatileP, _loopStarts, _loopEnds);
+		getInfo(info, dsp(), _pc, m_config, _cache, _volatileP, _loopStarts, _loopEnds, _branchProfile);
 
-		const auto pcNext = _pc + info.memSize;
+		bool hasLinkedEntry = false;
 
-		if(!isFastInterrupt && info.terminationReason != JitBlockInfo::TerminationReason::PopPC)
+		// a parent that calls us directly may pass registers in XMMs, it enters after they have been loaded here
+		if(_chain && m_config.linkJitBlocks && m_config.keepRegistersAcrossLinkedBlocks && !isFastInterrupt && !info.hasFlag(JitBlockInfo::Flags::IsLoopBodyBegin))
 		{
-			if(info.branchTarget == g_invalidAddress || info.branchIsConditional)
+			std::vector<JitDspRegPool::DspReg> regs;
+			getLinkedRegs(regs, info);
+
+			if(!regs.empty())
 			{
-				DspValue pc(*this, pcNext, DspValue::Immediate24);
-				m_dspRegPool.write(JitDspRegPool::DspPC, pc);
+				m_dspRegPool.loadLinkedRegs(_rt.m_linkedRegs, regs);
+
+				assert(m_stack.pushedSize() == 0);
+
+				_rt.m_linkedEntryLabel = m_asm.newNamedLabel("linkedEntry");
+				m_asm.bind(_rt.m_linkedEntryLabel);
+				hasLinkedEntry = true;
+			}
+		}
+
+		// Only blocks that are about to be executed see the N and M values that they run with. A parent entering via the linked entry would skip the guard
+		if(m_config.specializeAguRegisters && _chain && !isFastInterrupt && !hasLinkedEntry && m_dsp.getPC().var == _pc && _chain->canSpecializeAgu(_pc))
+			specializeAguRegisters(info, _chain, _pc);
+
+		// A DO loop that only accumulates the dot product of two linear buffers runs all but its last iteration in C++
+		if(m_config.vectorizeMacLoops && !isFastInterrupt && info.memSize == 1 &&
+			info.hasFlag(JitBlockInfo::Flags::IsLoopBodyBegin) && info.terminationReason == JitBlockInfo::TerminationReason::LoopEnd)
+		{
+			TWord op, opB, macLoopParams;
+			m_dsp.memory().getOpcode(_pc, op, opB);
+
+			// the kernel checks for linear addressing at runtime, no need to call it if the mode tells us already that it is not
+			auto mayBeLinear = [&](const TWord _agu)
+			{
+				const auto mode = getAddressingMode(_agu);
+				return mode == AddressingMode::Linear || mode == AddressingMode::Unknown;
+			};
+
+			if(JitMacLoop::isMacLoop(macLoopParams, m_dsp.opcodes(), op) &&
+				mayBeLinear(JitMacLoop::getAddressRegX(macLoopParams)) && mayBeLinear(JitMacLoop::getAddressRegY(macLoopParams)))
+			{
+				callMacLoop(macLoopParams, _pc);
+
+				// if iterations are left, they loop without calling it again
+				loopBegin = m_asm.newNamedLabel("macLoopRemainder");
+				m_asm.bind(loopBegin);
 			}
 		}
 
+		// A DO loop body that fits into this block is run as native loop. LC is kept in a host register for the whole loop,
+		// all other registers are written back at the end of each iteration so that every iteration starts with the same register pool state.
+		// Bodies are not unrolled, the write back at the end of each iteration would be repeated for every copy of the body
+		const auto isNativeLoop = m_config.nativeDoLoops && !isFastInterrupt &&
+			info.hasFlag(JitBlockInfo::Flags::IsLoopBodyBegin) && info.terminationReason == JitBlockInfo::TerminationReason::LoopEnd &&
+			!info.hasFlag(JitBlockInfo::Flags::HasSideExits) &&
+			!any(info.readRegs | info.writtenRegs, RegisterMask::LA | RegisterMask::LC | RegisterMask::SSH | RegisterMask::SSL | RegisterMask::SP);
+
+		asmjit::Label loopHead;
+
+		if(isNativeLoop)
+		{
+			// registers that are used for the first time inside of the loop would be pushed once per iteration otherwise
+			m_stack.pushNonVolatiles();
+
+			m_dspRegPool.get(JitDspRegPool::DspLC, true, true);
+			m_dspRegPool.lock(JitDspRegPool::DspLC);
+
+			loopHead = m_asm.newNamedLabel("loopHead");
+			m_asm.bind(loopHead);
+		}
+
+		cursorInsertEncodedInstructionCount = m_asm.cursor();	// inserted later below:	m_mem.mov(temp, getEncodedInstructionCount());
+
+		const auto pcNext = _pc + info.memSize;
+
+		const auto presetNextPC = !isFastInterrupt && info.terminationReason != JitBlockInfo::TerminationReason::PopPC && 
+			(info.branchTarget == g_invalidAddress || info.branchIsConditional);
+
+		if(presetNextPC)
+		{
+			DspValue pc(*this, pcNext, DspValue::Immediate24);
+			m_dspRegPool.write(JitDspRegPool::DspPC, pc);
+		}
+
+		const auto hasSideExits = info.hasFlag(JitBlockInfo::Flags::HasSideExits);
+
+		// code following a side exit is only executed if the side exit is not taken, it needs to count its instructions separately
+		struct SideExitSegment
+		{
+			asmjit::BaseNode* cursorInsertInstructionCount;
+			asmjit::BaseNode* cursorSideExitTaken;
+			TWord firstInstruction;
+		};
+		std::vector<SideExitSegment> sideExitSegments;
+
+		// Lazily computed CCR bits that are overwritten before anything can observe them. A parent that calls this block directly does not need to compute them.
+		// V is not included as updating it also updates the sticky L bit.
+		// A failing AGU guard returns before the first instruction, the parent has to provide a valid CCR in that case
+		auto& ccrOverwrittenOnEntry = _rt.m_ccrOverwrittenOnEntry;
+		ccrOverwrittenOnEntry = static_cast<CCRMask>(0);
+		bool scanCCROverwrittenOnEntry = m_specializedAgus == 0;
+
 		TWord opA = 0;
 		TWord opB = 0;
 
@@ -272,7 +377,10 @@ namespace dsp56k
 		{
 			opPC = _pc + pMemSize;
 
-			m_dsp.memory().getOpcode(opPC, opA, opB);
+			const auto& analysis = m_dsp.memory().getOpcodeAnalysis(opPC);
+
+			opA = analysis.opA;
+			opB = analysis.opB;
 
 			JitOps ops(*this, _rt, isFastInterrupt);
 
@@ -308,6 +416,39 @@ namespace dsp56k
 				profilingInfo.emplace_back(pi);
 			}
 
+			TWord sideExitPC = g_invalidAddress;
+
+			if(hasSideExits)
+			{
+				const auto pcFallthrough = opPC + analysis.length;
+
+				// every conditional branch that does not terminate the block is a side exit
+				if(JitBranchProfile::isConditionalBranch(analysis.instA, analysis.instB) && (pcFallthrough != pcNext || info.terminationReason != JitBlockInfo::TerminationReason::Branch))
+				{
+					sideExitPC = pcFallthrough;
+
+					DspValue pc(*this, sideExitPC, DspValue::Immediate24);
+					m_dspRegPool.write(JitDspRegPool::DspPC, pc);
+				}
+			}
+
+			const auto ccrDirtyBeforeOp = m_dspRegs.ccrDirtyFlags();
+			bool opWritesCCR = false;
+
+			if(scanCCROverwrittenOnEntry)
+			{
+				const auto instA = analysis.instA;
+				const auto written = analysis.written;
+				const auto read = analysis.read;
+				const auto flags = analysis.flags;
+
+				// stop at anything that reads the SR, leaves the block or calls C++ code that might look at the SR
+				if(any(read, RegisterMask::SR) || (flags & ~OpFlagCCR) || instA == Debug || instA == Reset || instA == Stop || instA == Wait || instA == Trap || instA == Illegal)
+					scanCCROverwrittenOnEntry = false;
+				else
+					opWritesCCR = (flags & OpFlagCCR) || any(written, RegisterMask::SR);
+			}
+
 			if(m_config.splitOpsByNops)
 				m_asm.nop();
 			ops.emit(opPC, opA, opB);
@@ -337,12 +478,35 @@ namespace dsp56k
 			++_rt.m_encodedInstructionCount;
 
 			_rt.m_lastOpSize = ops.getOpSize();
+
+			if(opWritesCCR)
+			{
+				ccrOverwrittenOnEntry = static_cast<CCRMask>(m_dspRegs.ccrDirtyFlags() & ~ccrDirtyBeforeOp & (CCR_E | CCR_N | CCR_U | CCR_Z));
+				scanCCROverwrittenOnEntry = false;
+			}
+
+			if(sideExitPC != g_invalidAddress)
+			{
+				auto* cursorTaken = emitSideExit(_rt, sideExitPC, isFastInterrupt);
+
+				sideExitSegments.push_back({m_asm.cursor(), cursorTaken, _rt.getEncodedInstructionCount()});
+
+				if(presetNextPC)
+				{
+					DspValue pc(*this, pcNext, DspValue::Immediate24);
+					m_dspRegPool.write(JitDspRegPool::DspPC, pc);
+				}
+			}
 		}
 
 		auto canBranch = info.terminationReason != JitBlockInfo::TerminationReason::WritePMem && !info.hasFlag(JitBlockInfo::Flags::ModeChange);
 
 		bool childIsConditional = false;
 
+		// child that does not exist yet but can be called once it has been compiled
+		TWord patchableChild = g_invalidAddress;
+		const auto canPatch = _chain && canBranch && m_config.linkJitBlocks && m_config.linkJitBlocksLate;
+
 		if(_chain && info.terminationReason == JitBlockInfo::TerminationReason::Branch)
 		{
 			// if the last instruction of a JIT block is a branch to an address known at compile time, and this branch is fixed, i.e. is not dependant
@@ -382,6 +546,10 @@ namespace dsp56k
 							}
 						}
 					}
+					else if (!childIsConditional && canPatch)
+					{
+						patchableChild = branchTarget;
+					}
 				}
 			}
 		}
@@ -389,13 +557,34 @@ namespace dsp56k
 		if (info.terminationReason == JitBlockInfo::TerminationReason::PopPC)
 			blockFlags |= JitOps::PopPC;
 
+		TWord instructionCount = _rt.getEncodedInstructionCount();
+
+		if(m_config.batchInstructionCount)
+		{
+			// count the whole block once on entry, the rarely taken side exits remove the instructions that did not run
+			for(const auto& segment : sideExitSegments)
+			{
+				m_asm.setCursor(segment.cursorSideExitTaken);
+				decreaseInstructionCount(instructionCount - segment.firstInstruction);
+			}
+		}
+		else
+		{
+			for(auto it = sideExitSegments.rbegin(); it != sideExitSegments.rend(); ++it)
+			{
+				m_asm.setCursor(it->cursorInsertInstructionCount);
+				increaseInstructionCount(asmjit::Imm(instructionCount - it->firstInstruction));
+				instructionCount = it->firstInstruction;
+			}
+		}
+
 		m_asm.setCursor(cursorInsertEncodedInstructionCount);
-		increaseInstructionCount(asmjit::Imm(_rt.getEncodedInstructionCount()));
+		increaseInstructionCount(asmjit::Imm(instructionCount));
 		m_asm.setCursor(m_asm.lastNode());
 
 		const auto isLoopStart = info.hasFlag(JitBlockInfo::Flags::IsLoopBodyBegin);
 		const auto isLoopEnd = info.terminationReason == JitBlockInfo::TerminationReason::LoopEnd;
-		const auto isLoopBody = isLoopStart && isLoopEnd;
+		const auto isLoopBody = isLoopStart && isLoopEnd && !isNativeLoop;
 
 		auto jumpIfLoop = [&](const asmjit::Label& _ifTrue, const JitRegGP& _compare)
 		{
@@ -445,6 +634,18 @@ namespace dsp56k
 
 			JitOps ops(*this, _rt, isFastInterrupt);
 
+			if(isNativeLoop)
+			{
+				// CCR does not need to be computed for the next iteration if the loop body writes it before reading it, the exit path below does it
+				const auto writesSRbeforeRead = info.hasFlag(JitBlockInfo::Flags::WritesSRbeforeRead);
+				const auto readsSR = (info.readRegs & RegisterMask::SR) != RegisterMask::None;
+
+				if(m_dspRegs.ccrDirtyFlags() && !writesSRbeforeRead && readsSR)
+					ops.updateDirtyCCR();
+
+				m_dspRegPool.releaseNonLocked();
+			}
+
 			// It is important that this code does not allocate any temp registers inside of the branches. thefore, we prewarm everything
 			RegGP temp(*this);
 
@@ -454,7 +655,8 @@ namespace dsp56k
 
 			m_dspRegPool.lock(JitDspRegPool::DspSR);
 			m_dspRegPool.lock(JitDspRegPool::DspLA);
-			m_dspRegPool.lock(JitDspRegPool::DspLC);
+			if(!isNativeLoop)
+				m_dspRegPool.lock(JitDspRegPool::DspLC);
 
 			DSPReg pc(*this, JitDspRegPool::DspPC, true, false);
 
@@ -474,6 +676,18 @@ namespace dsp56k
 #else
 				m_asm.shr(ss, asmjit::Imm(24));
 #endif
+				if(isNativeLoop)
+				{
+					// next iteration if the loop that is running is ours
+#ifdef HAVE_ARM64
+					const RegGP loopStart(*this);
+					m_asm.mov(r32(loopStart), asmjit::Imm(pcFirst));
+					m_asm.cmp(r32(ss), r32(loopStart));
+#else
+					m_asm.cmp(r32(ss), asmjit::Imm(pcFirst));
+#endif
+					m_asm.jz(loopHead);
+				}
 				setNextPC(ss);
 			}
 			m_asm.jmp(skip);
@@ -490,6 +704,40 @@ namespace dsp56k
 			profileEnd(pl);
 		}
 
+		canBranch &= _chain && childAddr != g_invalidAddress && childAddr != g_dynamicAddress && _chain->canBeDefaultExecuted(childAddr);
+
+		// if there is a block that is always called once we are done, CCR bits that it overwrites before reading them are dead on exit
+		const JitBlockRuntimeData* linkedChild = nullptr;
+		JitBlockRuntimeData* fallthroughChild = nullptr;
+
+		if(canBranch && !childIsConditional)
+		{
+			linkedChild = _chain->getChildBlock(nullptr, childAddr);
+		}
+		else if(!canBranch && !_rt.empty() && (info.terminationReason == JitBlockInfo::TerminationReason::ExistingCode || info.terminationReason == JitBlockInfo::TerminationReason::VolatileP))
+		{
+			if(!isFastInterrupt && !blockFlags && !isLoopEnd && _chain && _chain->canBeDefaultExecuted(pcNext))
+			{
+				fallthroughChild = _chain->getChildBlock(&_rt, pcNext, false);
+				if(fallthroughChild)
+				{
+					childAddr = pcNext;
+					fallthroughChild->addParent(pcFirst);
+					linkedChild = fallthroughChild;
+				}
+			}
+		}
+		else if(canPatch && !_rt.empty() && info.terminationReason == JitBlockInfo::TerminationReason::InstructionLimit)
+		{
+			if(!isFastInterrupt && !blockFlags && !isLoopEnd)
+				patchableChild = pcNext;
+		}
+
+		const auto ccrDead = linkedChild ? linkedChild->getCCROverwrittenOnEntry() : static_cast<CCRMask>(0);
+
+		if(m_dspRegs.ccrDirtyFlags() & ccrDead)
+			m_dspRegs.ccrDirtyFlags() = static_cast<CCRMask>(m_dspRegs.ccrDirtyFlags() & ~ccrDead);
+
 		if(m_dspRegs.ccrDirtyFlags())
 		{
 			auto pl = profileBegin("ccrUpdate");
@@ -517,11 +765,15 @@ namespace dsp56k
 
 		auto pl = profileBegin("release");
 
-		canBranch &= _chain && childAddr != g_invalidAddress && childAddr != g_dynamicAddress && _chain->canBeDefaultExecuted(childAddr);
-
 		if((canBranch && childIsConditional) || isLoopBody)
 			m_dspRegPool.read(regReturnVal, JitDspRegPool::DspPC);
 
+		// pass registers to the child in XMMs instead of storing them here and loading them there
+		const void* linkedEntry = nullptr;
+
+		if(linkedChild && m_config.keepRegistersAcrossLinkedBlocks && linkedChild->getLinkedEntry() && m_dspRegPool.passLinkedRegs(linkedChild->getLinkedRegs()))
+			linkedEntry = linkedChild->getLinkedEntry();
+
 		m_dspRegPool.releaseAll();
 		m_stack.popAll();
 
@@ -531,6 +783,9 @@ namespace dsp56k
 			return false;
 		}
 
+		if(linkedEntry)
+			++m_dsp.getJit().getStatistics().linkedEntries;
+
 		if (canBranch)
 		{
 			const auto* child = _chain->getChildBlock(nullptr, childAddr);
@@ -571,28 +826,24 @@ namespace dsp56k
 			}
 			else
 			{
-				m_stack.call(asmjit::func_as_ptr(child->getFunc()));
+				m_stack.call(linkedEntry ? linkedEntry : asmjit::func_as_ptr(child->getFunc()));
+
+				if(info.hasFlag(JitBlockInfo::Flags::SubroutineCall) && m_config.linkSubroutineReturns && !isFastInterrupt && !isLoopEnd)
+					callReturnChild(_rt, _chain, pcNext);
 			}
 		}
 		else if(!jumpIfLoop(loopBegin, regReturnVal))
 		{
-			if ((info.terminationReason == JitBlockInfo::TerminationReason::ExistingCode || info.terminationReason == JitBlockInfo::TerminationReason::VolatileP))
-			{
-				if(!isFastInterrupt && !blockFlags && !isLoopEnd && _chain && _chain->canBeDefaultExecuted(pcNext))
-				{
-					auto* child = _chain->getChildBlock(&_rt, pcNext, false);
-					if(child)
-					{
-						childAddr = pcNext;
-						child->addParent(pcFirst);
-						m_stack.call(asmjit::func_as_ptr(child->getFunc()));
-					}
-				}
-			}
+			if(fallthroughChild)
+				m_stack.call(linkedEntry ? linkedEntry : asmjit::func_as_ptr(fallthroughChild->getFunc()));
+			else if(patchableChild != g_invalidAddress)
+				callPatchableChild(_rt, patchableChild);
 		}
 
 		profileEnd(pl);
 
+		info.modeDependency = m_modeDependency;
+
 		/*
 		bool anyXmm = false;
 
@@ -645,6 +896,226 @@ namespace dsp56k
 		return true;
 	}
 
+	asmjit::BaseNode* JitBlock::emitSideExit(JitBlockRuntimeData& _rt, const TWord _pcFallthrough, const bool _isFastInterrupt)
+	{
+		// Only the taken path stores the DSP state, the fall-through path continues with the register pool and dirty CCR as they are.
+		// Make sure that SR is loaded on both paths so that the CCR update below does not allocate a pool register in the taken path only
+		const auto ccrDirty = m_dspRegs.ccrDirtyFlags();
+
+		if(ccrDirty)
+			m_dspRegs.getSR(JitDspRegs::ReadWrite);
+
+		m_dspRegPool.read(regReturnVal, JitDspRegPool::DspPC);
+
+		// pushes of nonvolatile registers caused by the taken path need to be executed on both paths
+		PushMover pm(*this);
+
+		const auto skip = m_asm.newLabel();
+
+#ifdef HAVE_ARM64
+		m_asm.mov(r32(g_funcArgGPs[1]), asmjit::Imm(_pcFallthrough));
+		m_asm.cmp(r32(regReturnVal), r32(g_funcArgGPs[1]));
+#else
+		m_asm.cmp(r32(regReturnVal), asmjit::Imm(_pcFallthrough));
+#endif
+		m_asm.jz(skip);
+
+		auto* cursorTaken = m_asm.cursor();
+
+		// the branch has been taken, store the DSP state and return to the dispatcher which continues at the branch target
+		if(ccrDirty)
+		{
+			JitOps op(*this, _rt, _isFastInterrupt);
+			op.updateDirtyCCR();
+		}
+
+		m_dspRegPool.storeWritten();
+
+		pm.end();
+
+		m_stack.popAllForEarlyReturn();
+		m_asm.ret();
+
+		m_asm.bind(skip);
+
+		// at compile time, the CCR update above has been recorded. It did not happen on the fall-through path
+		m_dspRegs.ccrDirtyFlags() = ccrDirty;
+
+		return cursorTaken;
+	}
+
+	void JitBlock::callReturnChild(JitBlockRuntimeData& _rt, JitBlockChain* _chain, const TWord _returnPc)
+	{
+		// The subroutine that we called returns to us if all of its blocks have been linked, including the one that does the RTS.
+		// If it returned to the op following our JSR, continue there directly. The native call stack acts as shadow return stack,
+		// a misprediction returns to the dispatcher as before
+		const auto skip = m_asm.newLabel();
+
+		m_dspRegPool.movDspReg(r32(regReturnVal), m_dsp.regs().pc);
+
+#ifdef HAVE_ARM64
+		m_asm.mov(r32(g_funcArgGPs[1]), asmjit::Imm(_returnPc));
+		m_asm.cmp(r32(regReturnVal), r32(g_funcArgGPs[1]));
+#else
+		m_asm.cmp(r32(regReturnVal), asmjit::Imm(_returnPc));
+#endif
+		m_asm.jnz(skip);
+
+		if(auto* child = _chain->getChildBlock(&_rt, _returnPc, false))
+		{
+			child->addParent(_rt.getPCFirst());
+			_rt.m_returnChild = _returnPc;
+			m_stack.call(asmjit::func_as_ptr(child->getFunc()));
+		}
+		else
+		{
+			// the code following the call has usually not been compiled yet
+			callPatchableChild(_rt, _returnPc);
+		}
+
+		m_asm.bind(skip);
+	}
+
+	void JitBlock::callPatchableChild(JitBlockRuntimeData& _rt, const TWord _childPc)
+	{
+		// The child did not exist when this block was generated. Once it has been compiled, the block chain stores its function in
+		// our runtime data. The code buffer is never written to, we load the function pointer and call it if it has been set
+		_rt.m_patchableChild = _childPc;
+
+		const auto skip = m_asm.newLabel();
+		const auto& func = regReturnVal;
+
+		m_asm.mov(func, asmjit::Imm(&_rt.m_patchedChild));
+#ifdef HAVE_ARM64
+		m_asm.ldr(func, Jitmem::makePtr(func, sizeof(TJitFunc)));
+		m_asm.cbz(func, skip);
+#else
+		m_asm.mov(func, Jitmem::makePtr(func, sizeof(TJitFunc)));
+		m_asm.test(func, func);
+		m_asm.jz(skip);
+#endif
+		m_stack.call(func);
+
+		m_asm.bind(skip);
+	}
+
+	void JitBlock::callMacLoop(const TWord _params, const TWord _pc)
+	{
+		const FuncArg r0(*this, 0);
+		const FuncArg r1(*this, 1);
+		const FuncArg r2(*this, 2);
+		const FuncArg r3(*this, 3);
+
+		m_asm.mov(r0, asmjit::Imm(&m_dsp));
+		m_asm.mov(r1, asmjit::Imm(_params));
+		m_asm.mov(r2, asmjit::Imm(_pc));
+		m_stack.call(asmjit::func_as_ptr(&JitMacLoop::exec));
+	}
+
+	void JitBlock::specializeAguRegisters(const JitBlockInfo& _info, JitBlockChain* _chain, const TWord _pc)
+	{
+		// N and M of AGUs that the block reads but never writes are compiled as immediates. Modulo addressing turns into an add and compares
+		// with immediates this way. If the registers do not have these values on block entry, the guard returns to the dispatcher before
+		// anything has been executed and the block is compiled again without specialization
+		const auto& regs = m_dsp.regs();
+
+		for(uint32_t i=0; i<m_specializedN.size(); ++i)
+		{
+			const auto n = static_cast<RegisterMask>(static_cast<uint64_t>(RegisterMask::N0) << i);
+			const auto m = static_cast<RegisterMask>(static_cast<uint64_t>(RegisterMask::M0) << i);
+
+			if(!any(_info.readRegs, n) || any(_info.writtenRegs, n | m))
+				continue;
+
+			const auto mode = JitDspMode::calcAddressingMode(regs.m[i]);
+
+			if(mode != AddressingMode::Linear && mode != AddressingMode::Modulo)
+				continue;
+
+			m_specializedAgus |= 1 << i;
+			m_specializedN[i] = regs.n[i].var;
+			m_specializedM[i] = regs.m[i].var;
+		}
+
+		if(!m_specializedAgus)
+			return;
+
+		const auto guardFailed = m_asm.newNamedLabel("aguGuardFailed");
+		const auto guardPassed = m_asm.newNamedLabel("aguGuardPassed");
+
+		auto guard = [&](const TReg24& _reg, const TWord _value)
+		{
+			m_dspRegPool.movDspReg(r32(regReturnVal), _reg);
+#ifdef HAVE_ARM64
+			m_asm.mov(r32(g_funcArgGPs[1]), asmjit::Imm(_value));
+			m_asm.cmp(r32(regReturnVal), r32(g_funcArgGPs[1]));
+#else
+			m_asm.cmp(r32(regReturnVal), asmjit::Imm(_value));
+#endif
+			m_asm.jnz(guardFailed);
+		};
+
+		for(uint32_t i=0; i<m_specializedN.size(); ++i)
+		{
+			if(!isAguSpecialized(i))
+				continue;
+
+			guard(regs.n[i], m_specializedN[i]);
+			guard(regs.m[i], m_specializedM[i]);
+		}
+
+		m_asm.jmp(guardPassed);
+
+		m_asm.bind(guardFailed);
+		{
+			const FuncArg r0(*this, 0);
+			const FuncArg r1(*this, 1);
+
+			m_asm.mov(r0, asmjit::Imm(_chain));
+			m_asm.mov(r1, asmjit::Imm(_pc));
+			m_stack.call(asmjit::func_as_ptr(&callAguGuardFailed));
+		}
+		m_stack.popAllForEarlyReturn();
+		m_asm.ret();
+
+		m_asm.bind(guardPassed);
+	}
+
+	bool JitBlock::getSpecializedAgu(TWord& _n, TWord& _m, const uint32_t _aguIndex) const
+	{
+		if(!isAguSpecialized(_aguIndex))
+			return false;
+
+		_n = m_specializedN[_aguIndex];
+		_m = m_specializedM[_aguIndex];
+		return true;
+	}
+
+	void JitBlock::getLinkedRegs(std::vector<JitDspRegPool::DspReg>& _regs, const JitBlockInfo& _info)
+	{
+		// registers that are kept in XMMs across linked blocks. Only registers that are read and written are considered,
+		// they would be loaded and stored anyway so loading them up front does not cost anything if the block is entered from C++
+		constexpr std::pair<RegisterMask, JitDspRegPool::DspReg> candidates[] =
+		{
+			{RegisterMask::A, JitDspRegPool::DspA},
+			{RegisterMask::B, JitDspRegPool::DspB},
+			{RegisterMask::X, JitDspRegPool::DspX},
+			{RegisterMask::Y, JitDspRegPool::DspY},
+			{RegisterMask::R0, JitDspRegPool::DspR0},
+			{RegisterMask::R1, JitDspRegPool::DspR1},
+			{RegisterMask::R2, JitDspRegPool::DspR2},
+			{RegisterMask::R3, JitDspRegPool::DspR3}
+		};
+
+		_regs.clear();
+
+		for (const auto& c : candidates)
+		{
+			if(any(_info.readRegs, c.first) && any(_info.writtenRegs, c.first))
+				_regs.push_back(c.second);
+		}
+	}
+
 	void JitBlock::setNextPC(const JitRegGP& _pc)
 	{
 		m_dspRegPool.write(JitDspRegPool::DspPC, _pc);
@@ -680,14 +1151,41 @@ namespace dsp56k
 #endif
 	}
 
+	void JitBlock::decreaseInstructionCount(const TWord _count)
+	{
+		if(!_count)
+			return;
+
+		const auto ptr = dspRegPool().makeDspPtr(&m_dsp.getInstructionCounter(), sizeof(TWord));
+
+#ifdef HAVE_ARM64
+		const RegScratch scratch(*this);
+		const auto r = r32(scratch);
+		m_asm.ldr(r, ptr);
+		m_asm.sub(r, r, asmjit::Imm(_count));
+		m_asm.str(r, ptr);
+#else
+		m_asm.sub(ptr, asmjit::Imm(_count));
+#endif
+	}
+
 	AddressingMode JitBlock::getAddressingMode(const uint32_t _aguIndex) const
 	{
-		return m_chain ? m_chain->getMode().getAddressingMode(_aguIndex) : AddressingMode::Unknown;
+		if(!m_chain)
+			return AddressingMode::Unknown;
+
+		m_modeDependency |= JitDspMode::getAddressingModeMask(_aguIndex);
+		return m_chain->getCodeMode().getAddressingMode(_aguIndex);
 	}
 
 	const JitDspMode* JitBlock::getMode() const
 	{
-		return m_chain ? &m_chain->getMode() : nullptr;
+		if(!m_chain)
+			return nullptr;
+
+		// we do not know which SR bits the caller is going to test
+		m_modeDependency |= JitDspMode::SRMask;
+		return &m_chain->getCodeMode();
 	}
 
 	void JitBlock::reset()
@@ -698,6 +1196,8 @@ namespace dsp56k
 		m_dspRegs.reset();
 		m_dspRegPool.reset();
 		m_scratchLocked = false;
+		m_modeDependency = 0;
+		m_specializedAgus = 0;
 	}
 
 	JitBlock::JitBlockGenerating::JitBlockGenerating(JitBlockRuntimeData& _block): m_block(_block)
@@ -12,6 +12,8 @@
 
 #include "opcodeanalysis.h"
 
+#include <array>
+#include <map>
 #include <string>
 #include <vector>
 #include <set>
@@ -32,6 +34,7 @@ namespace dsp56k
 	class DSP;
 	class JitBlockChain;
 	class JitBlockRuntimeData;
+	class JitBranchProfile;
 	class JitDspMode;
 
 	class JitBlock final
@@ -41,9 +44,9 @@ namespace dsp56k
 		JitBlock(JitEmitter& _a, DSP& _dsp, JitRuntimeData& _runtimeData, const JitConfig& _config);
 		~JitBlock();
 
-		static void getInfo(JitBlockInfo& _info, const DSP& _dsp, TWord _pc, const JitConfig& _config, const std::vector<JitCacheEntry>& _cache, const std::set<TWord>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds);
+		static void getInfo(JitBlockInfo& _info, const DSP& _dsp, TWord _pc, const JitConfig& _config, const std::vector<JitCacheEntry>& _cache, const std::vector<bool>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds, const JitBranchProfile* _branchProfile);
 
-		bool emit(JitBlockRuntimeData& _rt, JitBlockChain* _chain, TWord _pc, const std::vector<JitCacheEntry>& _cache, const std::set<TWord>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds, bool _profilingSupport);
+		bool emit(JitBlockRuntimeData& _rt, JitBlockChain* _chain, TWord _pc, const std::vector<JitCacheEntry>& _cache, const std::vector<bool>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds, const JitBranchProfile* _branchProfile, bool _profilingSupport);
 
 		JitEmitter& asm_() { return m_asm; }
 		DSP& dsp() { return m_dsp; }
@@ -70,6 +73,10 @@ namespace dsp56k
 		AddressingMode getAddressingMode(uint32_t _aguIndex) const;
 		const JitDspMode* getMode() const;
 
+		// AGUs whose N and M values are compiled as immediates, see JitConfig::specializeAguRegisters
+		bool isAguSpecialized(const uint32_t _aguIndex) const { return (m_specializedAgus & (1 << _aguIndex)) != 0; }
+		bool getSpecializedAgu(TWord& _n, TWord& _m, uint32_t _aguIndex) const;
+
 		void lockScratch()
 		{
 			assert(!m_scratchLocked && "scratch reg is already locked");
@@ -94,6 +101,14 @@ namespace dsp56k
 			JitBlockRuntimeData& m_block;
 		};
 
+		asmjit::BaseNode* emitSideExit(JitBlockRuntimeData& _rt, TWord _pcFallthrough, bool _isFastInterrupt);
+		void decreaseInstructionCount(TWord _count);
+		void callReturnChild(JitBlockRuntimeData& _rt, JitBlockChain* _chain, TWord _returnPc);
+		void callPatchableChild(JitBlockRuntimeData& _rt, TWord _childPc);
+		void callMacLoop(TWord _params, TWord _pc);
+		void specializeAguRegisters(const JitBlockInfo& _info, JitBlockChain* _chain, TWord _pc);
+		static void getLinkedRegs(std::vector<JitDspRegPool::DspReg>& _regs, const JitBlockInfo& _info);
+
 		JitRuntimeData& m_runtimeData;
 
 		JitEmitter& m_asm;
@@ -109,5 +124,10 @@ namespace dsp56k
 		JitBlockChain* m_chain = nullptr;
 
 		bool m_scratchLocked = false;
+		mutable uint32_t m_modeDependency = 0;
+
+		uint32_t m_specializedAgus = 0;
+		std::array<TWord, 8> m_specializedN{};
+		std::array<TWord, 8> m_specializedM{};
 	};
 }
@@ -2,6 +2,7 @@
 
 #include "dsp.h"
 #include "jitasmjithelpers.h"
+#include "jitblockinfo.h"
 #include "jitblockruntimedata.h"
 #include "jitblock.h"
 #include "jitemitter.h"
@@ -14,8 +15,11 @@ namespace dsp56k
 	void funcRun(Jit* _jit, TWord _pc);
 	void funcCreate(Jit* _jit, TWord _pc);
 	void funcRecreate(Jit* _jit, TWord _pc);
+	void funcInterpret(Jit* _jit, TWord _pc);
+	void funcRunShared(Jit* _jit, TWord _pc);
+	void funcRunClosures(Jit* _jit, TWord _pc);
 
-	JitBlockChain::JitBlockChain(Jit& _jit, const JitDspMode& _mode) : m_jit(_jit), m_mode(_mode)
+	JitBlockChain::JitBlockChain(Jit& _jit, const JitDspMode& _mode, const bool _shared) : m_jit(_jit), m_mode(_mode), m_codeMode(_mode), m_shared(_shared)
 	{
 		m_logger.reset(new AsmJitLogger());
 		m_errorHandler.reset(new AsmJitErrorHandler());
@@ -24,6 +28,9 @@ namespace dsp56k
 		const auto pSize = mem.sizeP();
 		m_jitCache.resize(pSize);
 		m_jitFuncs.resize(pSize, &funcCreate);
+
+		if(m_shared)
+			m_modeDependent.resize(pSize, false);
 	}
 
 	JitBlockChain::~JitBlockChain()
@@ -32,16 +39,14 @@ namespace dsp56k
 		{
 			if(e.block)
 				destroy(e.block);
-
-			if(e.singleOpCache)
-			{
-				for (const auto& it : *e.singleOpCache)
-					release(it.second);
-
-				e.singleOpCache->clear();
-			}
 		}
 
+		m_singleOpCache.forEach([this](JitBlockRuntimeData* _block)
+		{
+			release(_block);
+		});
+
+		m_singleOpCache.clear();
 		m_jitCache.clear();
 	}
 
@@ -61,6 +66,8 @@ namespace dsp56k
 		for (auto i = first; i < last; ++i)
 		{
 			assert(m_jitCache[i].block == nullptr || m_jitCache[i].block == _block);
+			if(!m_jitCache[i].block)
+				m_jit.addCompiledP(i);
 			m_jitCache[i].block = _block;
 			if (i == first)
 				m_jitFuncs[i] = Jit::updateRunFunc(m_jitCache[i]);
@@ -78,6 +85,8 @@ namespace dsp56k
 
 		for(auto i=first; i<last; ++i)
 		{
+			if(m_jitCache[i].block == _block)
+				m_jit.removeCompiledP(i);
 			m_jitCache[i].block = nullptr;
 			m_jitFuncs[i] = &funcCreate;
 		}
@@ -90,78 +99,192 @@ namespace dsp56k
 	{
 //		LOG("Create @ " << HEX(_pc));// << std::endl << cacheEntry.block->getDisasm());
 
-		auto& cacheEntry = m_jitCache[_pc];
+		if(createFromSingleOpCache(_pc))
+		{
+			if(_execute)
+				exec(_pc);
+			return;
+		}
 
-		if(cacheEntry.singleOpCache)
+		if(_execute && m_jit.getConfig().hotThreshold)
 		{
-			TWord opA;
-			TWord opB;
-			m_jit.dsp().memory().getOpcode(_pc, opA, opB);
+			if(isCold(_pc))
+			{
+				// The count is kept once the address is hot. If its block is evicted or destroyed later, it is compiled
+				// again right away instead of going through another warm-up
+				if(++m_jitCache[_pc].execCount == m_jit.getConfig().hotThreshold)
+					++m_jit.getStatistics().promotedBlocks;
 
-			// try to find two-word op first
-			auto key = JitBlockRuntimeData::getSingleOpCacheKey(opA, opB);
+				m_jit.interpret(_pc);
+				return;
+			}
+		}
 
-			auto it = cacheEntry.findSingleOp(key);
+		if(_execute && m_jit.getConfig().useCompileQueue && m_jit.canInterpret(_pc))
+		{
+			defer(_pc);
+			exec(_pc);
+			return;
+		}
 
-			uint32_t cacheEntryLen = 2;
+		if(!createShared(_pc))
+			emit(_pc);
 
-			// if not found, try one-word op
-			if(!cacheEntry.isValid(it))
-			{
-				key = JitBlockRuntimeData::getSingleOpCacheKey(opA, JitBlockRuntimeData::SingleOpCacheIgnoreWordB);
-				it = cacheEntry.findSingleOp(key);
-				cacheEntryLen = 1;
-			}
+		if(_execute)
+			exec(_pc);
+	}
 
-			if(cacheEntry.isValid(it))
-			{
-				if(cacheEntryLen == 1 || m_jitCache[_pc+1].block == nullptr)
-				{
-//					LOG("Returning single-op " << HEX(opA) << " at PC " << HEX(_pc));
-					assert(cacheEntry.block == nullptr);
+	bool JitBlockChain::createShared(const TWord _pc)
+	{
+		if(m_shared || !m_jit.getConfig().shareModeIndependentBlocks)
+			return false;
 
-					cacheEntry.block = it->second;
-					cacheEntry.removeSingleOp(it);
+		if(!m_jit.getSharedChain(m_mode)->provideShared(_pc))
+			return false;
 
-					occupyArea(cacheEntry.block);
+		// the block is owned by the shared chain, we forward to it
+		m_jitFuncs[_pc] = &funcRunShared;
+		++m_jit.getStatistics().sharedBlocks;
+		return true;
+	}
 
-					if(_execute)
-						exec(_pc);
-					return;
-				}
-			}
+	bool JitBlockChain::canSpecializeAgu(const TWord _pc) const
+	{
+		return m_jit.canSpecializeAgu(_pc);
+	}
+
+	void JitBlockChain::aguGuardFailed(const TWord _pc)
+	{
+		// called by the JIT code of the block at _pc, it is still running. It is recreated without specialization when executed next time
+		m_jit.onAguGuardFailed(_pc);
+		m_jitFuncs[_pc] = &funcRecreate;
+	}
+
+	bool JitBlockChain::provideShared(const TWord _pc)
+	{
+		assert(m_shared);
+
+		if(m_modeDependent[_pc])
+			return false;
+
+		const auto& e = m_jitCache[_pc];
+
+		if(!e.block || e.block->getPCFirst() != _pc)
+		{
+			if(e.block)
+				destroy(e.block);
+
+			create(_pc, false);
 		}
 
-		emit(_pc);
-		if(_execute)
-			exec(_pc);
+		return canBeDefaultExecuted(_pc);
+	}
+
+	bool JitBlockChain::isShareable(const JitBlockInfo& _info)
+	{
+		// blocks that need to return to the dispatcher of the mode chain via Jit::run cannot be shared
+		return !_info.modeDependency && !_info.hasFlag(JitBlockInfo::Flags::ModeChange) && _info.terminationReason != JitBlockInfo::TerminationReason::WritePMem;
+	}
+
+	bool JitBlockChain::createFromSingleOpCache(const TWord _pc)
+	{
+		auto& cacheEntry = m_jitCache[_pc];
+
+		if(!cacheEntry.singleOpCount)
+			return false;
+
+		TWord opA;
+		TWord opB;
+		m_jit.dsp().memory().getOpcode(_pc, opA, opB);
+
+		// try to find two-word op first
+		auto key = JitBlockRuntimeData::getSingleOpCacheKey(opA, opB);
+
+		auto* block = m_singleOpCache.find(_pc, key);
+
+		uint32_t cacheEntryLen = 2;
+
+		// if not found, try one-word op
+		if(!block)
+		{
+			key = JitBlockRuntimeData::getSingleOpCacheKey(opA, JitBlockRuntimeData::SingleOpCacheIgnoreWordB);
+			block = m_singleOpCache.find(_pc, key);
+			cacheEntryLen = 1;
+		}
+
+		if(!block)
+			return false;
+
+		if(cacheEntryLen != 1 && m_jitCache[_pc+1].block != nullptr)
+			return false;
+
+//		LOG("Returning single-op " << HEX(opA) << " at PC " << HEX(_pc));
+		assert(cacheEntry.block == nullptr);
+
+		cacheEntry.block = block;
+		m_singleOpCache.remove(_pc, key);
+		--cacheEntry.singleOpCount;
+
+		occupyArea(cacheEntry.block);
+
+		addPatchableParent(block);
+		patchParents(block);
+
+		return true;
+	}
+
+	bool JitBlockChain::isCold(const TWord _pc) const
+	{
+		const auto threshold = m_jit.getConfig().hotThreshold;
+		return threshold && m_jitCache[_pc].execCount < threshold && m_jit.canInterpret(_pc);
+	}
+
+	void JitBlockChain::defer(const TWord _pc)
+	{
+		// code at this address is run by the interpreter until the compile queue has processed it
+		m_jitFuncs[_pc] = &funcInterpret;
+		m_jit.enqueueCompile(m_mode, _pc);
+	}
+
+	void JitBlockChain::compileDeferred(const TWord _pc)
+	{
+		// the address might have been compiled in the meantime, either as child of another block or as part of a larger block
+		if(m_jitFuncs[_pc] != &funcInterpret)
+			return;
+
+		m_jitFuncs[_pc] = &funcCreate;
+
+		if(m_jitCache[_pc].block)
+			return;
+
+		if(!createFromSingleOpCache(_pc) && !createShared(_pc))
+			emit(_pc);
 	}
 
 	void JitBlockChain::destroyParents(JitBlockRuntimeData* _block)
 	{
+		// parents that have been linked after they have been generated do not need to be destroyed, they return to the dispatcher again
+		unpatchParents(_block);
+
 		for (const auto parent : _block->getParents())
 		{
-			const auto& e = m_jitCache[parent];
+			auto& e = m_jitCache[parent];
 
 			if (e.block)
 				destroy(e.block);
 
 			// single op cached entries that are calling the child block need to go, too. They have been created at a time where _block was not a volatile P block yet
-			if(e.singleOpCache)
+			if(e.singleOpCount)
 			{
-				for(auto it = e.singleOpCache->begin(); it != e.singleOpCache->end();)
+				m_singleOpCache.removeIf(parent, [&](JitBlockRuntimeData* _b)
 				{
-					auto* b = it->second;
-					if (b->getChild() == _block->getPCFirst() || b->getNonBranchChild() == _block->getPCFirst())
-					{
-						release(b);
-						e.singleOpCache->erase(it++);
-					}
-					else
-					{
-						++it;
-					}
-				}
+					if (_b->getChild() != _block->getPCFirst() && _b->getNonBranchChild() != _block->getPCFirst() && _b->getReturnChild() != _block->getPCFirst())
+						return false;
+
+					release(_b);
+					--e.singleOpCount;
+					return true;
+				});
 			}
 		}
 		_block->clearParents();
@@ -173,6 +296,9 @@ namespace dsp56k
 
 		unoccupyArea(_block);
 
+		// the child might be gone while the block is in the single-op cache, it is linked again once it is reused
+		_block->setPatchedChild(nullptr);
+
 		if(m_jit.getConfig().cacheSingleOpBlocks && _block->getPMemSize() <= 2 && _block->getEncodedInstructionCount() == 1)
 		{
 			// if a single-word-op, cache it
@@ -180,11 +306,12 @@ namespace dsp56k
 			auto& cacheEntry = m_jitCache[first];
 			const auto op = _block->getSingleOpCacheKey();
 
-			if(!cacheEntry.containsSingleOp(op))
+			if(!m_singleOpCache.contains(first, op))
 			{
 //				LOG("Caching single-op block " << HEX(op) << " at PC " << HEX(first));
 
-				cacheEntry.addSingleOp(op, _block);
+				m_singleOpCache.add(first, op, _block);
+				++cacheEntry.singleOpCount;
 				return;
 			}
 		}
@@ -201,6 +328,44 @@ namespace dsp56k
 			destroy(block);
 	}
 
+	void JitBlockChain::touch(const TWord _pc, const uint64_t _epoch) const
+	{
+		if(auto* b = m_jitCache[_pc].block)
+			b->setLastUsed(_epoch);
+	}
+
+	bool JitBlockChain::evict(const TWord _pc)
+	{
+		auto* block = m_jitCache[_pc].block;
+
+		if(!block || block->getPCFirst() != _pc || isBeingGenerated(block))
+			return false;
+
+		destroyParents(block);
+		unoccupyArea(block);
+		release(block);
+
+		return true;
+	}
+
+	size_t JitBlockChain::clearSingleOpCache()
+	{
+		const auto count = m_singleOpCache.size();
+
+		if(!count)
+			return 0;
+
+		m_singleOpCache.forEach([this](JitBlockRuntimeData* _block)
+		{
+			m_jitCache[_block->getPCFirst()].singleOpCount = 0;
+			release(_block);
+		});
+
+		m_singleOpCache.clear();
+
+		return count;
+	}
+
 	void JitBlockChain::release(JitBlockRuntimeData* _block)
 	{
 #if DSP56300_DEBUGGER
@@ -210,7 +375,9 @@ namespace dsp56k
 #endif
 		assert(m_codeSize >= _block->codeSize());
 		m_codeSize -= _block->codeSize();
-		m_jit.getRuntime()->release(_block->getFunc());
+
+		if(!_block->isClosureBlock())
+			m_jit.getRuntime()->release(_block->getFunc());
 
 		m_jit.releaseBlockRuntimeData(_block);
 
@@ -253,6 +420,10 @@ namespace dsp56k
 		if (!_allowCreate)
 			return nullptr;
 
+		// do not spend compile time and code memory on code that has not been run often enough yet
+		if (isCold(_pc))
+			return nullptr;
+
 		// If we jump into the middle of an existing block, this block needs to be regenerated.
 		// However, we can only destroy blocks that are not part of the recursive generation that is running at the moment
 		if (isBeingGeneratedRecursive(e.block))
@@ -270,6 +441,48 @@ namespace dsp56k
 	}
 
 	JitBlockRuntimeData* JitBlockChain::emit(TWord _pc)
+	{
+		auto* b = m_jit.getConfig().closureBlocks ? emitClosures(_pc) : emitCode(_pc);
+
+		if(!b)
+			return nullptr;
+
+		b->setLastUsed(m_jit.getEpoch());
+
+		if(m_shared && !isShareable(b->getInfo()))
+		{
+			// generated per mode from now on, the mode chains compile it themselves
+			m_modeDependent[_pc] = true;
+			++m_jit.getStatistics().modeDependentBlocks;
+
+			// linking children occupies the area of the parent already
+			if(m_jitCache[_pc].block == b)
+				unoccupyArea(b);
+
+			release(b);
+			return nullptr;
+		}
+
+//		LOG("Total code size now " << (m_codeSize >> 10) << "kb");
+
+		occupyArea(b);
+
+		addPatchableParent(b);
+		patchParents(b);
+
+		auto* profiling = m_jit.getProfilingSupport();
+		if (profiling && !b->isClosureBlock())
+			profiling->addJitBlock(*b);
+
+#if DSP56300_DEBUGGER
+		auto* d = m_jit.dsp().getDebugger();
+		if(d)
+			d->onJitBlockCreated(m_mode, b);
+#endif
+		return b;
+	}
+
+	JitBlockRuntimeData* JitBlockChain::emitCode(const TWord _pc)
 	{
 //		AsmJitLogger m_logger;
 //		m_logger.addFlags(asmjit::FormatFlags::kHexImms | /*asmjit::FormatFlags::kHexOffsets |*/ asmjit::FormatFlags::kMachineCode);
@@ -290,7 +503,7 @@ namespace dsp56k
 
 		m_generatingBlocks.insert(std::make_pair(_pc, b));
 
-		if(!emitter->block.emit(*b, this, _pc, m_jitCache, m_jit.getVolatileP(), m_jit.getLoops(), m_jit.getLoopEnds(), m_jit.getProfilingSupport()))
+		if(!emitter->block.emit(*b, this, _pc, m_jitCache, m_jit.getVolatileP(), m_jit.getLoops(), m_jit.getLoopEnds(), &m_jit.getBranchProfile(), m_jit.getProfilingSupport()))
 		{
 			LOG("FATAL: code generation failed for PC " << HEX(_pc));
 			m_jit.releaseBlockRuntimeData(b);
@@ -322,22 +535,150 @@ namespace dsp56k
 
 		m_jit.releaseEmitter(emitter);
 
-//		LOG("Total code size now " << (m_codeSize >> 10) << "kb");
+		return b;
+	}
 
-		occupyArea(b);
+	JitBlockRuntimeData* JitBlockChain::emitClosures(const TWord _pc)
+	{
+		// the block runs interpreter handlers, it neither links to other blocks nor depends on the DSP mode
+		JitBlockInfo info;
+		JitBlock::getInfo(info, m_jit.dsp(), _pc, m_jit.getConfig(), m_jitCache, m_jit.getVolatileP(), m_jit.getLoops(), m_jit.getLoopEnds(), &m_jit.getBranchProfile());
 
-		auto* profiling = m_jit.getProfilingSupport();
-		if (profiling)
-			profiling->addJitBlock(*b);
+		JitClosures closures;
+		m_jit.createClosures(closures, info);
+
+		bool shared;
+		auto sharedClosures = m_jit.shareClosures(m_codeMode, info, std::move(closures), shared);
+
+		auto* b = m_jit.acquireBlockRuntimeData();
+		b->finalizeClosures(&funcRunClosures, info, std::move(sharedClosures), shared);
+		m_codeSize += b->codeSize();
 
-#if DSP56300_DEBUGGER
-		auto* d = m_jit.dsp().getDebugger();
-		if(d)
-			d->onJitBlockCreated(m_mode, b);
-#endif
 		return b;
 	}
 
+	void JitBlockChain::addPatchableParent(JitBlockRuntimeData* _parent)
+	{
+		const auto childPc = _parent->getPatchableChild();
+
+		if(childPc == g_invalidAddress)
+			return;
+
+		m_patchableParents[childPc].insert(_parent->getPCFirst());
+
+		const auto* child = m_jitCache[childPc].block;
+
+		if(child && child->getPCFirst() == childPc)
+			patch(_parent, child);
+	}
+
+	void JitBlockChain::patchParents(const JitBlockRuntimeData* _child)
+	{
+		const auto it = m_patchableParents.find(_child->getPCFirst());
+
+		if(it == m_patchableParents.end())
+			return;
+
+		auto& parents = it->second;
+
+		for(auto itParent = parents.begin(); itParent != parents.end();)
+		{
+			auto* parent = getPatchableParent(*itParent, _child->getPCFirst());
+
+			// the parent has been destroyed in the meantime
+			if(!parent)
+			{
+				itParent = parents.erase(itParent);
+				continue;
+			}
+
+			patch(parent, _child);
+			++itParent;
+		}
+
+		if(parents.empty())
+			m_patchableParents.erase(it);
+	}
+
+	void JitBlockChain::unpatchParents(const JitBlockRuntimeData* _child)
+	{
+		const auto it = m_patchableParents.find(_child->getPCFirst());
+
+		if(it == m_patchableParents.end())
+			return;
+
+		// parents stay registered, they are patched again if the child is recreated
+		for (const auto parentPc : it->second)
+		{
+			auto* parent = getPatchableParent(parentPc, _child->getPCFirst());
+
+			if(parent && parent->getPatchedChild() == _child->getFunc())
+				parent->setPatchedChild(nullptr);
+		}
+	}
+
+	void JitBlockChain::patch(JitBlockRuntimeData* _parent, const JitBlockRuntimeData* _child) const
+	{
+		if(_parent->getPatchedChild())
+			return;
+
+		const auto pc = _child->getPCFirst();
+
+		if(m_jit.isVolatileP(pc) || !canBeDefaultExecuted(pc))
+			return;
+
+		// a linked child runs without returning to the dispatcher. If the child can reach the parent, they would call each other forever
+		if(isLinked(_child, _parent))
+		{
+			++m_jit.getStatistics().cyclicLinks;
+			return;
+		}
+
+		_parent->setPatchedChild(_child->getFunc());
+		++m_jit.getStatistics().patchedLinks;
+	}
+
+	JitBlockRuntimeData* JitBlockChain::getPatchableParent(const TWord _parentPc, const TWord _childPc) const
+	{
+		auto* parent = m_jitCache[_parentPc].block;
+
+		if(!parent || parent->getPCFirst() != _parentPc || parent->getPatchableChild() != _childPc)
+			return nullptr;
+
+		return parent;
+	}
+
+	bool JitBlockChain::isLinked(const JitBlockRuntimeData* _from, const JitBlockRuntimeData* _to) const
+	{
+		std::vector<const JitBlockRuntimeData*> pending{_from};
+		std::set<const JitBlockRuntimeData*> visited;
+
+		while(!pending.empty())
+		{
+			const auto* b = pending.back();
+			pending.pop_back();
+
+			if(b == _to)
+				return true;
+
+			if(!visited.insert(b).second)
+				continue;
+
+			const TWord children[] = {b->getChild(), b->getNonBranchChild(), b->getReturnChild(), b->getPatchedChild() ? b->getPatchableChild() : g_invalidAddress};
+
+			for (const auto child : children)
+			{
+				// invalid or dynamic address
+				if(child >= m_jitCache.size())
+					continue;
+
+				if(const auto* c = m_jitCache[child].block)
+					pending.push_back(c);
+			}
+		}
+		return false;
+	}
+
 	bool JitBlockChain::isBeingGeneratedRecursive(const JitBlockRuntimeData* _block) const
 	{
 		if (!_block)
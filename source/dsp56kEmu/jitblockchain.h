@@ -1,10 +1,13 @@
 #pragma once
 
 #include <memory>
+#include <map>
+#include <set>
 #include <vector>
 
 #include "jitcacheentry.h"
 #include "jitdspmode.h"
+#include "jitsingleopcache.h"
 
 namespace dsp56k
 {
@@ -12,11 +15,12 @@ namespace dsp56k
 	class AsmJitErrorHandler;
 	class DSP;
 	class JitBlockRuntimeData;
+	struct JitBlockInfo;
 
 	class JitBlockChain final
 	{
 	public:
-		JitBlockChain(Jit& _jit, const JitDspMode& _mode);
+		JitBlockChain(Jit& _jit, const JitDspMode& _mode, bool _shared = false);
 		~JitBlockChain();
 
 		bool canBeDefaultExecuted(TWord _pc) const;
@@ -25,6 +29,8 @@ namespace dsp56k
 		void recreate(TWord _pc);
 		void destroy(TWord _pc);
 
+		void compileDeferred(TWord _pc);
+
 		JitBlockRuntimeData* getChildBlock(JitBlockRuntimeData* _parent, TWord _pc, bool _allowCreate = true);
 		JitBlockRuntimeData* emit(TWord _pc);
 
@@ -33,6 +39,11 @@ namespace dsp56k
 			return m_jitCache[_pc].block;
 		}
 
+		const JitBlockRuntimeData* getBlock(const TWord _pc) const
+		{
+			return m_jitCache[_pc].block;
+		}
+
 		const TJitFunc& getFunc(const TWord _pc) const
 		{
 			return m_jitFuncs[_pc];
@@ -53,7 +64,39 @@ namespace dsp56k
 			return m_mode;
 		}
 
+		// mode that code is generated for. The shared chain generates code for the mode that is active when a block is requested
+		const JitDspMode& getCodeMode() const
+		{
+			return m_codeMode;
+		}
+
+		void setCodeMode(const JitDspMode& _mode)
+		{
+			m_codeMode = _mode;
+		}
+
+		bool isShared() const { return m_shared; }
+		bool provideShared(TWord _pc);
+		void resetModeDependency(const TWord _pc) { m_modeDependent[_pc] = false; }
+
+		bool canSpecializeAgu(TWord _pc) const;
+		void aguGuardFailed(TWord _pc);
+
+		size_t getCodeSize() const { return m_codeSize; }
+
+		void touch(TWord _pc, uint64_t _epoch) const;
+		bool evict(TWord _pc);
+		size_t clearSingleOpCache();
+
 	private:
+		JitBlockRuntimeData* emitCode(TWord _pc);
+		JitBlockRuntimeData* emitClosures(TWord _pc);
+
+		bool createFromSingleOpCache(TWord _pc);
+		bool createShared(TWord _pc);
+		static bool isShareable(const JitBlockInfo& _info);
+		bool isCold(TWord _pc) const;
+		void defer(TWord _pc);
 
 		void destroyParents(JitBlockRuntimeData* _block);
 		void destroy(JitBlockRuntimeData* _block);
@@ -62,16 +105,28 @@ namespace dsp56k
 		void occupyArea(JitBlockRuntimeData* _block);
 		void unoccupyArea(const JitBlockRuntimeData* _block);
 
+		void addPatchableParent(JitBlockRuntimeData* _parent);
+		void patchParents(const JitBlockRuntimeData* _child);
+		void unpatchParents(const JitBlockRuntimeData* _child);
+		void patch(JitBlockRuntimeData* _parent, const JitBlockRuntimeData* _child) const;
+		JitBlockRuntimeData* getPatchableParent(TWord _parentPc, TWord _childPc) const;
+		bool isLinked(const JitBlockRuntimeData* _from, const JitBlockRuntimeData* _to) const;
+
 		bool isBeingGeneratedRecursive(const JitBlockRuntimeData* _block) const;
 		bool isBeingGenerated(const JitBlockRuntimeData* _block) const;
 
 		Jit& m_jit;
 		const JitDspMode m_mode;
+		JitDspMode m_codeMode;
+		const bool m_shared;
 
 		std::vector<JitCacheEntry> m_jitCache;
 		std::vector<TJitFunc> m_jitFuncs;
+		JitSingleOpCache m_singleOpCache;
+		std::vector<bool> m_modeDependent;	// shared chain only: addresses whose code has to be generated per mode
 
 		std::map<TWord, JitBlockRuntimeData*> m_generatingBlocks;
+		std::map<TWord, std::set<TWord>> m_patchableParents;	// child PC => PCs of blocks that call the child once it exists
 
 		std::unique_ptr<AsmJitLogger> m_logger;
 		std::unique_ptr<AsmJitErrorHandler> m_errorHandler;
@@ -29,6 +29,8 @@ namespace dsp56k
 			WritesSRbeforeRead	= 0x01,
 			ModeChange			= 0x02,
 			IsLoopBodyBegin		= 0x04,
+			HasSideExits		= 0x08,
+			SubroutineCall		= 0x10,
 		};
 
 		auto hasFlag(const Flags _flag) const
@@ -55,6 +57,7 @@ namespace dsp56k
 			branchIsConditional = false;
 			loopBegin = g_invalidAddress;
 			loopEnd = g_invalidAddress;
+			modeDependency = 0;
 		}
 
 		TerminationReason terminationReason = TerminationReason::None;
@@ -69,5 +72,6 @@ namespace dsp56k
 		bool branchIsConditional = false;
 		TWord loopBegin = g_invalidAddress;
 		TWord loopEnd = g_invalidAddress;
+		uint32_t modeDependency = 0;	// JitDspMode bits that the generated code depends on, known once the block has been emitted
 	};
 }
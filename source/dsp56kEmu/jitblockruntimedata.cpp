@@ -22,6 +22,9 @@ namespace dsp56k
 		m_func = _func;
 		m_codeSize = _codeHolder.codeSize();
 
+		if(m_linkedEntryLabel.isValid())
+			m_linkedEntryOffset = _codeHolder.labelOffset(m_linkedEntryLabel);
+
 		for (auto& pi : m_profilingInfo)
 		{
 			pi.codeOffset = _codeHolder.labelOffset(pi.labelBefore);
@@ -29,6 +32,27 @@ namespace dsp56k
 		}
 	}
 
+	void JitBlockRuntimeData::finalizeClosures(const TJitFunc& _func, const JitBlockInfo& _info, std::shared_ptr<const JitClosures> _closures, const bool _shared)
+	{
+		assert(_closures && !_closures->empty());
+
+		m_closures = std::move(_closures);
+		m_sharedClosures = _shared;
+
+		const auto& last = m_closures->back();
+
+		m_func = _func;
+		m_info = _info;
+
+		m_pcFirst = _info.pc;
+		m_pMemSize = _info.memSize;
+		m_lastOpSize = last.len;
+		m_singleOpWordA = last.op;
+		m_singleOpWordB = last.opB;
+		m_encodedInstructionCount = static_cast<TWord>(m_closures->size());
+		m_codeSize = m_closures->size() * sizeof(JitClosure);
+	}
+
 	void JitBlockRuntimeData::reset()
 	{
 		m_func = nullptr;
@@ -44,13 +68,31 @@ namespace dsp56k
 		m_possibleBranch = false;
 		m_child = g_invalidAddress;			// JIT block that we call
 		m_nonBranchChild = g_invalidAddress;
+		m_returnChild = g_invalidAddress;
 		m_codeSize = 0;
+		m_lastUsed = 0;
+		m_ccrOverwrittenOnEntry = static_cast<CCRMask>(0);
+		m_linkedRegs.clear();
+		m_linkedEntryLabel.reset();
+		m_linkedEntryOffset = 0;
+		m_patchableChild = g_invalidAddress;
+		m_patchedChild = nullptr;
 
 		m_info.reset();
 
 		m_parents.clear();
 		m_generating = false;
 		m_profilingInfo.clear();
+		m_closures.reset();
+		m_sharedClosures = false;
+	}
+
+	const void* JitBlockRuntimeData::getLinkedEntry() const
+	{
+		if(m_linkedRegs.empty() || !m_func)
+			return nullptr;
+
+		return reinterpret_cast<const uint8_t*>(asmjit::func_as_ptr(m_func)) + m_linkedEntryOffset;
 	}
 
 	void JitBlockRuntimeData::addParent(const TWord _pc)
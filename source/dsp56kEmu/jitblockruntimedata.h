@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <set>
 
 #include "jitblock.h"
@@ -7,8 +8,21 @@
 
 namespace dsp56k
 {
+	class DSP;
 	class JitBlock;
 
+	// interpreter handler of a single op, resolved when the block is created. See JitConfig::closureBlocks
+	struct JitClosure
+	{
+		void (DSP::*func)(TWord _op) = nullptr;
+		TWord pc = 0;
+		TWord op = 0;
+		TWord opB = 0;
+		TWord len = 0;	// P words up to the next closure, the op repeated by a REP is part of the REP closure
+	};
+
+	using JitClosures = std::vector<JitClosure>;
+
 	class JitBlockRuntimeData final
 	{
 	public:
@@ -60,6 +74,7 @@ namespace dsp56k
 
 		TWord getChild() const { return m_child; }
 		TWord getNonBranchChild() const { return m_nonBranchChild; }
+		TWord getReturnChild() const { return m_returnChild; }
 		size_t codeSize() const { return m_codeSize; }
 		const std::set<TWord>& getParents() const { return m_parents; }
 		void clearParents() { m_parents.clear(); }
@@ -69,6 +84,7 @@ namespace dsp56k
 		TWord getPMemSize() const { return m_pMemSize; }
 
 		void finalize(const TJitFunc& _func, const asmjit::CodeHolder& _codeHolder);
+		void finalizeClosures(const TJitFunc& _func, const JitBlockInfo& _info, std::shared_ptr<const JitClosures> _closures, bool _shared);
 
 		const TJitFunc& getFunc() const { return m_func; }
 
@@ -79,6 +95,22 @@ namespace dsp56k
 
 		const JitBlockInfo& getInfo() const { return m_info; }
 
+		uint64_t getLastUsed() const { return m_lastUsed; }
+		void setLastUsed(const uint64_t _epoch) { m_lastUsed = _epoch; }
+
+		CCRMask getCCROverwrittenOnEntry() const { return m_ccrOverwrittenOnEntry; }
+
+		const std::vector<JitDspRegPool::LinkedReg>& getLinkedRegs() const { return m_linkedRegs; }
+		const void* getLinkedEntry() const;
+
+		TWord getPatchableChild() const { return m_patchableChild; }
+		const TJitFunc& getPatchedChild() const { return m_patchedChild; }
+		void setPatchedChild(const TJitFunc& _func) { m_patchedChild = _func; }
+
+		const JitClosures& getClosures() const { return *m_closures; }
+		bool isClosureBlock() const { return m_closures != nullptr; }
+		bool hasSharedClosures() const { return m_sharedClosures; }
+
 		void reset();
 
 	private:
@@ -97,12 +129,22 @@ namespace dsp56k
 		bool m_possibleBranch = false;
 		TWord m_child = g_invalidAddress;			// JIT block that we call
 		TWord m_nonBranchChild = g_invalidAddress;
+		TWord m_returnChild = g_invalidAddress;		// JIT block that we call if a subroutine called by us returned to the op following the call
 		size_t m_codeSize = 0;
+		uint64_t m_lastUsed = 0;	// epoch at which this block was last seen running, used for code size budget eviction
+		CCRMask m_ccrOverwrittenOnEntry = static_cast<CCRMask>(0);	// CCR bits that this block overwrites before they can be observed
+		std::vector<JitDspRegPool::LinkedReg> m_linkedRegs;			// registers that a parent may pass in XMMs when calling the linked entry
+		asmjit::Label m_linkedEntryLabel;
+		uint64_t m_linkedEntryOffset = 0;
+		TWord m_patchableChild = g_invalidAddress;	// child that did not exist when this block was generated
+		TJitFunc m_patchedChild = nullptr;			// read by the generated code, the child is called if set
 
 		JitBlockInfo m_info;
 
 		std::set<TWord> m_parents;
 		bool m_generating = false;
 		std::vector<InstructionProfilingInfo> m_profilingInfo;
+		std::shared_ptr<const JitClosures> m_closures;
+		bool m_sharedClosures = false;	// closures are owned by the JitCodeRepository, other instances might run them, too
 	};
 }
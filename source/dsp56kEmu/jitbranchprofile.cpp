@@ -0,0 +1,46 @@
+#include "jitbranchprofile.h"
+
+#include "jitconfig.h"
+#include "opcodes.h"
+
+namespace dsp56k
+{
+	void JitBranchProfile::add(const TWord _pc, const bool _taken)
+	{
+		auto& e = m_entries[_pc];
+
+		if(_taken)
+			++e.taken;
+		else
+			++e.notTaken;
+	}
+
+	bool JitBranchProfile::isRarelyTaken(const TWord _pc, const JitConfig& _config) const
+	{
+		const auto* e = getEntry(_pc);
+
+		if(!e)
+			return false;
+
+		const uint64_t total = static_cast<uint64_t>(e->taken) + e->notTaken;
+
+		if(total < MinSamples)
+			return false;
+
+		return static_cast<uint64_t>(e->taken) * 100 <= total * _config.superblockMaxTakenPercent;
+	}
+
+	const JitBranchProfile::Entry* JitBranchProfile::getEntry(const TWord _pc) const
+	{
+		const auto it = m_entries.find(_pc);
+		return it != m_entries.end() ? &it->second : nullptr;
+	}
+
+	bool JitBranchProfile::isConditionalBranch(const Instruction _instA, const Instruction _instB)
+	{
+		if(!(Opcodes::getFlags(_instA, _instB) & OpFlagBranch))
+			return false;
+
+		return hasField(_instA, Field_CCCC) || hasField(_instA, Field_bbbbb);
+	}
+}
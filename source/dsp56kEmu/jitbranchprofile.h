@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+
+#include "opcodetypes.h"
+#include "types.h"
+
+namespace dsp56k
+{
+	struct JitConfig;
+
+	// Records how often conditional branches are taken while code is interpreted before it is compiled (see
+	// JitConfig::hotThreshold). A conditional branch that is rarely taken does not terminate a JIT block, the block
+	// continues with the likely path and leaves via a side exit if the branch is taken after all
+	class JitBranchProfile
+	{
+	public:
+		static constexpr uint32_t MinSamples = 8;
+
+		struct Entry
+		{
+			uint32_t taken = 0;
+			uint32_t notTaken = 0;
+		};
+
+		void add(TWord _pc, bool _taken);
+		void clear() { m_entries.clear(); }
+
+		bool isRarelyTaken(TWord _pc, const JitConfig& _config) const;
+
+		const Entry* getEntry(TWord _pc) const;
+
+		static bool isConditionalBranch(Instruction _instA, Instruction _instB);
+
+	private:
+		std::map<TWord, Entry> m_entries;
+	};
+}
@@ -1,7 +1,5 @@
 #pragma once
 
-#include <map>
-
 #include "types.h"
 
 namespace dsp56k
@@ -13,47 +11,8 @@ namespace dsp56k
 
 	struct JitCacheEntry
 	{
-		using SingleOpMap = std::map<uint64_t, JitBlockRuntimeData*>;
-		using SingleOpMapIt = SingleOpMap::iterator;
-
-		~JitCacheEntry()
-		{
-			delete singleOpCache;
-		}
-
-		SingleOpMapIt findSingleOp(const uint64_t _key) const
-		{
-			if(!singleOpCache)
-				return {};
-
-			return singleOpCache->find(_key);
-		}
-
-		bool containsSingleOp(const uint64_t _key) const
-		{
-			return singleOpCache != nullptr && singleOpCache->find(_key) != singleOpCache->end();
-		}
-
-		void removeSingleOp(const SingleOpMapIt& _it)
-		{
-			if(!singleOpCache)
-				return;
-			singleOpCache->erase(_it);
-		}
-
-		void addSingleOp(const uint64_t _key, JitBlockRuntimeData* _block)
-		{
-			if(!singleOpCache)
-				singleOpCache = new std::map<uint64_t, JitBlockRuntimeData*>();
-			singleOpCache->insert(std::make_pair(_key, _block));
-		}
-
-		bool isValid(const SingleOpMapIt& _it) const
-		{
-			return singleOpCache != nullptr && _it != singleOpCache->end();
-		}
-
 		JitBlockRuntimeData* block = nullptr;
-		std::map<uint64_t, JitBlockRuntimeData*>* singleOpCache = nullptr;
+		uint32_t singleOpCount = 0;	// number of blocks in the single op cache of the chain for this address
+		uint32_t execCount = 0;		// number of interpreted executions, see JitConfig::hotThreshold
 	};
 }
@@ -0,0 +1,145 @@
+#include "jitcoderepository.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace dsp56k
+{
+	namespace
+	{
+		constexpr uint64_t g_fnvOffsetBasis = 0xcbf29ce484222325ull;
+		constexpr uint64_t g_fnvPrime = 0x100000001b3ull;
+
+		uint64_t fnv1a(uint64_t _hash, const uint64_t _value)
+		{
+			for(uint32_t i=0; i<sizeof(_value); ++i)
+			{
+				_hash ^= (_value >> (i<<3)) & 0xff;
+				_hash *= g_fnvPrime;
+			}
+			return _hash;
+		}
+
+		struct Entry
+		{
+			uint32_t mode;
+			uint64_t configHash;
+			std::weak_ptr<const JitClosures> closures;
+		};
+
+		std::mutex g_mutex;
+		std::unordered_map<uint64_t, std::vector<Entry>> g_entries;	// hash => blocks with that hash
+
+		uint64_t calcHash(const uint32_t _mode, const uint64_t _configHash, const JitClosures& _closures)
+		{
+			auto hash = fnv1a(fnv1a(g_fnvOffsetBasis, _mode), _configHash);
+
+			for (const auto& c : _closures)
+			{
+				hash = fnv1a(hash, c.pc);
+				hash = fnv1a(hash, (static_cast<uint64_t>(c.op) << 32) | c.opB);
+				hash = fnv1a(hash, c.len);
+			}
+
+			return hash;
+		}
+
+		bool equals(const JitClosures& _a, const JitClosures& _b)
+		{
+			return std::equal(_a.begin(), _a.end(), _b.begin(), _b.end(), [](const JitClosure& _x, const JitClosure& _y)
+			{
+				return _x.func == _y.func && _x.pc == _y.pc && _x.op == _y.op && _x.opB == _y.opB && _x.len == _y.len;
+			});
+		}
+
+		void removeExpired(std::vector<Entry>& _entries)
+		{
+			_entries.erase(std::remove_if(_entries.begin(), _entries.end(), [](const Entry& _e)
+			{
+				return _e.closures.expired();
+			}), _entries.end());
+		}
+
+		// invoked when the last instance releases a block
+		struct Release
+		{
+			uint64_t hash;
+
+			void operator()(const JitClosures* _closures) const
+			{
+				{
+					std::lock_guard lock(g_mutex);
+
+					const auto it = g_entries.find(hash);
+
+					if(it != g_entries.end())
+					{
+						removeExpired(it->second);
+
+						if(it->second.empty())
+							g_entries.erase(it);
+					}
+				}
+
+				delete _closures;
+			}
+		};
+	}
+
+	JitCodeRepository::SharedClosures JitCodeRepository::share(const uint32_t _mode, const uint64_t _configHash, JitClosures&& _closures, bool& _found)
+	{
+		const auto hash = calcHash(_mode, _configHash, _closures);
+
+		// blocks that we look at might be released by their last instance meanwhile, our reference has to be dropped
+		// after the mutex has been unlocked as the release locks it, too
+		std::vector<SharedClosures> candidates;
+
+		std::lock_guard lock(g_mutex);
+
+		auto& entries = g_entries[hash];
+
+		for (const auto& e : entries)
+		{
+			if(e.mode != _mode || e.configHash != _configHash)
+				continue;
+
+			auto closures = e.closures.lock();
+
+			if(!closures)
+				continue;
+
+			if(equals(*closures, _closures))
+			{
+				_found = true;
+				return closures;
+			}
+
+			candidates.push_back(std::move(closures));
+		}
+
+		_found = false;
+
+		SharedClosures closures(new JitClosures(std::move(_closures)), Release{hash});
+		entries.push_back({_mode, _configHash, closures});
+
+		return closures;
+	}
+
+	size_t JitCodeRepository::size()
+	{
+		std::lock_guard lock(g_mutex);
+
+		size_t count = 0;
+
+		for (const auto& it : g_entries)
+		{
+			count += std::count_if(it.second.begin(), it.second.end(), [](const Entry& _e)
+			{
+				return !_e.closures.expired();
+			});
+		}
+
+		return count;
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "jitblockruntimedata.h"
+
+namespace dsp56k
+{
+	// Process-wide repository of closure blocks, see JitConfig::shareClosureBlocks. Blocks are keyed by the P memory
+	// contents they have been created from, the DSP mode and the JIT config. A closure does not refer to a DSP instance,
+	// the DSP that runs a block passes itself to the handlers, which allows all instances to run the same copy.
+	// A block is removed as soon as the last instance that uses it has released it
+	class JitCodeRepository
+	{
+	public:
+		using SharedClosures = std::shared_ptr<const JitClosures>;
+
+		// returns the block of another instance if one with the same contents, mode and config exists. Otherwise,
+		// _closures is added to the repository. _found is set to true if an existing block has been returned
+		static SharedClosures share(uint32_t _mode, uint64_t _configHash, JitClosures&& _closures, bool& _found);
+
+		// number of blocks in the repository
+		static size_t size();
+	};
+}
@@ -14,5 +14,22 @@ namespace dsp56k
 		bool dynamicPeripheralAddressing = false;
 		uint32_t maxInstructionsPerBlock = 0;
 		bool memoryWritesCallCpp = false;
+		bool useCompileQueue = false;					// defer compilation of new code, run it via the interpreter until it has been compiled
+		uint32_t compileQueueBlocksPerStep = 1;			// max number of queued blocks that are compiled per peripheral processing step
+		uint32_t hotThreshold = 0;						// number of interpreted executions of an address before it is compiled, 0 = compile immediately
+		bool buildSuperblocks = false;					// continue blocks across rarely taken conditional branches, requires a branch profile gathered via hotThreshold
+		uint32_t superblockMaxTakenPercent = 10;		// a conditional branch is considered to be rarely taken if it was taken at most this often
+		uint32_t maxCodeSize = 0;						// max size of generated code in bytes, least recently used blocks are evicted if exceeded. 0 = unlimited
+		bool shareJitRuntime = false;					// allocate code from a JIT runtime shared by all instances in the process. Evaluated when the first block is compiled
+		bool keepRegistersAcrossLinkedBlocks = false;	// pass frequently used DSP registers from a block to its linked child in XMM registers instead of memory
+		bool linkJitBlocksLate = false;					// blocks whose child did not exist at compile time call it as soon as it has been compiled
+		bool linkSubroutineReturns = false;				// after a linked subroutine call, continue at the return address without the dispatcher if the subroutine returned there
+		bool nativeDoLoops = false;						// run DO loop bodies that fit into one block as native loop with LC kept in a host register
+		bool vectorizeMacLoops = false;					// run DO loops that only accumulate X:(Rn)+ * Y:(Rm)+ via MAC in a vectorizable C++ kernel
+		bool shareModeIndependentBlocks = false;		// blocks whose code does not depend on the DSP mode are generated once and shared by all mode chains
+		bool specializeAguRegisters = false;			// compile N and M values that a block does not modify as immediates, guarded at block entry. Falls back to generic code if the guard fails
+		bool batchInstructionCount = false;				// superblocks update the instruction counter once on entry instead of once per side exit segment, taken side exits correct it
+		bool closureBlocks = false;						// run blocks as lists of pre-resolved interpreter handlers instead of generated code. Works on hosts that are not supported by the JIT
+		bool shareClosureBlocks = false;				// closure blocks are shared by all instances in the process that run the same code with the same mode and config
 	};
 }
@@ -30,6 +30,11 @@ namespace dsp56k
 		return static_cast<AddressingMode>((m_mode >> (_aguIndex << g_aguShift)) & 0x3);
 	}
 
+	uint32_t JitDspMode::getAddressingModeMask(const uint32_t _aguIndex)
+	{
+		return 0x3 << (_aguIndex << g_aguShift);
+	}
+
 	uint32_t JitDspMode::getSR() const
 	{
 		return (m_mode >> 8) & 0xffff00;
@@ -13,8 +13,10 @@ namespace dsp56k
 	{
 	public:
 		static constexpr uint32_t Uninitialized = 0xffffffff;
+		static constexpr uint32_t SRMask = 0xffff0000;
 
 		void initialize(const DSP& _dsp);
+		void initialize(const uint32_t _mode) { m_mode = _mode; }
 		auto get() const { return m_mode; }
 		AddressingMode getAddressingMode(uint32_t _aguIndex) const;
 
@@ -24,6 +26,7 @@ namespace dsp56k
 		bool operator != (const JitDspMode& _m) const		{ return m_mode != _m.m_mode; }
 
 		static AddressingMode calcAddressingMode(const TReg24& _m);
+		static uint32_t getAddressingModeMask(uint32_t _aguIndex);
 
 		uint32_t getSR() const;
 		uint32_t testSR(SRBit _bit) const;
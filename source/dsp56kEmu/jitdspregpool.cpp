@@ -257,6 +257,26 @@ namespace dsp56k
 		}
 	}
 
+	void JitDspRegPool::storeWritten()
+	{
+		// store written registers to memory but keep them in the pool. Used on paths that leave the block early
+		for(auto i=0; i<DspCount; ++i)
+		{
+			const auto r = static_cast<DspReg>(i);
+
+			if(!isWritten(r))
+				continue;
+
+			JitRegGP gp;
+			SpillReg xm;
+
+			if(m_gpList.get(gp, r))
+				store(r, gp);
+			else if(m_xmList.get(xm, r))
+				store(r, xm);
+		}
+	}
+
 	void JitDspRegPool::debugStoreAll()
 	{
 		for(auto i=0; i<DspCount; ++i)
@@ -273,6 +293,96 @@ namespace dsp56k
 		}
 	}
 
+	void JitDspRegPool::loadLinkedRegs(std::vector<LinkedReg>& _linkedRegs, const std::vector<DspReg>& _regs)
+	{
+		// Loads registers into the first spill XMMs. A parent block that has these registers in XMMs already skips this code.
+		// They are marked as written as the parent does not store them to memory when passing them to us
+		assert(m_gpList.empty() && m_xmList.empty() && "linked registers need to be loaded first");
+
+		_linkedRegs.clear();
+
+		for (const auto r : _regs)
+		{
+			if(_linkedRegs.size() >= getMaxLinkedRegCount())
+				break;
+
+			SpillReg xm;
+			m_xmList.acquire(xm, r, m_repMode);
+			assert(!JitStackHelper::isNonVolatile(xm.reg) && xm.offset == 0);
+			m_block.stack().setUsed(xm.reg);
+
+			load(xm, r);
+
+			setLoaded(r);
+			setSpilled(r);
+			setWritten(r);
+			m_moveToXmmInstruction[r] = nullptr;
+
+			_linkedRegs.push_back({r, xm});
+		}
+	}
+
+	bool JitDspRegPool::passLinkedRegs(const std::vector<LinkedReg>& _linkedRegs)
+	{
+		if(_linkedRegs.empty() || _linkedRegs.size() > std::size(g_dspPoolGps))
+			return false;
+
+		if(m_lockedGps != DspRegFlags::None || isInUse(DspAwrite) || isInUse(DspBwrite))
+			return false;
+
+		auto linked = DspRegFlags::None;
+		for (const auto& lr : _linkedRegs)
+			flagSet(linked, lr.reg);
+
+		LOGRP("Passing linked registers to child block");
+
+		// store everything that the child does not receive in registers
+		for(size_t i=0; i<DspCount; ++i)
+		{
+			const auto r = static_cast<DspReg>(i);
+			if(!flagTest(linked, r) && isInUse(r))
+				release(r);
+		}
+
+		// fetch all linked registers into GPs first, the XMMs that they are passed in might be occupied otherwise
+		for (const auto& lr : _linkedRegs)
+			get(lr.reg, true, false);
+
+		assert(m_xmList.empty());
+
+		for (const auto& lr : _linkedRegs)
+		{
+			JitRegGP gp;
+			m_gpList.get(gp, lr.reg);
+			m_block.stack().setUsed(lr.xm.reg);
+			spillMove(lr.xm, gp);
+		}
+
+		// the child stores them when it is done
+		for (const auto& lr : _linkedRegs)
+		{
+			clearWritten(lr.reg);
+			release(lr.reg);
+		}
+
+		return true;
+	}
+
+	size_t JitDspRegPool::getMaxLinkedRegCount()
+	{
+		// the registers are loaded before any non-volatile registers are pushed, which allows the parent to skip the loads
+		size_t count = 0;
+
+		for (const auto& xm : g_dspPoolXmms)
+		{
+			if(!xm.isValid() || JitStackHelper::isNonVolatile(xm))
+				break;
+			++count;
+		}
+
+		return count;
+	}
+
 	bool JitDspRegPool::isInUse(const JitReg128& _xmm) const
 	{
 		return m_xmList.isUsed({_xmm, 0}) || m_xmList.isUsed({_xmm, 1});
@@ -637,6 +747,40 @@ namespace dsp56k
 		}
 	}
 
+	void JitDspRegPool::load(const SpillReg& _dst, const DspReg _src) const
+	{
+		const auto& r = m_block.dsp().regs();
+
+		switch (_src)
+		{
+		case DspR0:
+		case DspR1:
+		case DspR2:
+		case DspR3:
+		case DspR4:
+		case DspR5:
+		case DspR6:
+		case DspR7:
+			movDspReg(_dst, r.r[_src - DspR0]);
+			break;
+		case DspA:
+			movDspReg(_dst, r.a);
+			break;
+		case DspB:
+			movDspReg(_dst, r.b);
+			break;
+		case DspX:
+			movDspReg(_dst, r.x);
+			break;
+		case DspY:
+			movDspReg(_dst, r.y);
+			break;
+		default:
+			assert(false && "register cannot be loaded into an XMM directly");
+			break;
+		}
+	}
+
 	void JitDspRegPool::store(const DspReg _dst, const JitRegGP& _src) const
 	{
 		const auto& r = m_block.dsp().regs();
@@ -94,6 +94,13 @@ namespace dsp56k
 			}
 		};
 
+		// a DSP register that a parent block passes to a linked child block in an XMM register instead of storing it to memory
+		struct LinkedReg
+		{
+			DspReg reg = DspRegInvalid;
+			SpillReg xm;
+		};
+
 		JitDspRegPool(JitBlock& _block);
 		~JitDspRegPool();
 
@@ -117,8 +124,13 @@ namespace dsp56k
 		void releaseLoaded();
 		void releaseByFlags(DspRegFlags _flags);
 
+		void storeWritten();
 		void debugStoreAll();
 
+		void loadLinkedRegs(std::vector<LinkedReg>& _linkedRegs, const std::vector<DspReg>& _regs);
+		bool passLinkedRegs(const std::vector<LinkedReg>& _linkedRegs);
+		static size_t getMaxLinkedRegCount();
+
 		bool hasWrittenRegs() const { return m_writtenDspRegs != DspRegFlags::None; }
 
 		DspRegFlags getLoadedRegs() const { return m_loadedDspRegs; }
@@ -183,6 +195,16 @@ namespace dsp56k
 			static_assert(sizeof(_reg.var) == sizeof(uint64_t) || sizeof(_reg.var) == sizeof(uint32_t), "unknown register size");
 		}
 
+		template<typename T, unsigned int B>
+		void movDspReg(const SpillReg& _dst, const RegType<T, B>& _reg) const
+		{
+			if constexpr (sizeof(_reg.var) == sizeof(uint32_t))
+				movd(_dst.reg, makeDspPtr(_reg));
+			else if constexpr (sizeof(_reg.var) == sizeof(uint64_t))
+				movq(_dst.reg, makeDspPtr(_reg));
+			static_assert(sizeof(_reg.var) == sizeof(uint64_t) || sizeof(_reg.var) == sizeof(uint32_t), "unknown register size");
+		}
+
 		void movDspReg(const TWord& _reg, const SpillReg& _src) const
 		{
 			movd(makeDspPtr(&_reg, sizeof(_reg)), _src);
@@ -226,6 +248,7 @@ namespace dsp56k
 		void clear();
 
 		void load(const JitRegGP& _dst, DspReg _src);
+		void load(const SpillReg& _dst, DspReg _src) const;
 		void store(DspReg _dst, const JitRegGP& _src) const;
 		void store(DspReg _dst, const SpillReg& _src) const;
 
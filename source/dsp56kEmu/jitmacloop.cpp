@@ -0,0 +1,155 @@
+#include "jitmacloop.h"
+
+#include "dsp.h"
+#include "opcodes.h"
+
+#include <algorithm>
+
+namespace dsp56k
+{
+	namespace
+	{
+		// A single product is at most 2^47. Adding 127 of them to an accumulator whose magnitude is at most 2^54 stays
+		// within 2^55, no intermediate result can overflow 56 bits and the V and L bits remain unchanged
+		constexpr TWord g_chunkSize = 127;
+		constexpr int64_t g_maxAccumulator = 1ll << 54;
+
+		int64_t signextend24(const TWord _v)
+		{
+			return static_cast<int32_t>(_v << 8) >> 8;
+		}
+
+		int64_t dotProduct(const TWord* _x, const TWord* _y, const TWord _count)
+		{
+			int64_t sum = 0;
+
+			for(TWord i=0; i<_count; ++i)
+				sum += signextend24(_x[i]) * signextend24(_y[i]);
+
+			return sum;
+		}
+	}
+
+	bool JitMacLoop::isMacLoop(TWord& _params, const Opcodes& _opcodes, const TWord _op)
+	{
+		Instruction instA, instB;
+		_opcodes.getInstructionTypes(_op, instA, instB);
+
+		// Mac_S1S2 does not include MACR
+		if(instA != Mac_S1S2 || instB != Movexy)
+			return false;
+
+		const auto negate = (_op >> 2) & 1;
+		const auto ab = (_op >> 3) & 1;
+		const auto qqq = (_op >> 4) & 7;
+
+		// the multiplication needs to use one X and one Y register, see DSP::decode_QQQ_read
+		if(qqq < 4)
+			return false;
+
+		const TWord xReg = qqq >= 6 ? 1 : 0;
+		const TWord yReg = (qqq == 4 || qqq == 7) ? 1 : 0;
+
+		const auto MM = getFieldValue<Movexy, Field_MM>(_op);
+		const auto RRR = getFieldValue<Movexy, Field_RRR>(_op);
+		const auto mm = getFieldValue<Movexy, Field_mm>(_op);
+		const auto rr = getFieldValue<Movexy, Field_rr>(_op);
+		const auto writeX = getFieldValue<Movexy, Field_W>(_op);
+		const auto writeY = getFieldValue<Movexy, Field_w>(_op);
+		const auto ee = getFieldValue<Movexy, Field_ee>(_op);
+		const auto ff = getFieldValue<Movexy, Field_ff>(_op);
+
+		// both moves need to be (Rn)+ reads into the registers that are multiplied
+		if(!writeX || !writeY || MM != 3 || mm != 3 || ee != xReg || ff != yReg)
+			return false;
+
+		const TWord regIdxOffset = RRR >= 4 ? 0 : 4;
+		const TWord rrr = (rr + regIdxOffset) & 7;
+
+		_params = RRR | (rrr << 3) | (xReg << 6) | (yReg << 7) | (ab << 8) | (negate << 9);
+		return true;
+	}
+
+	void JitMacLoop::exec(DSP* _dsp, const TWord _params, const TWord _pc)
+	{
+		auto& dsp = *_dsp;
+		auto& regs = dsp.regs();
+
+#if DSP56300_DEBUGGER
+		// the debugger wants to see every memory read
+		if(dsp.getDebugger())
+			return;
+#endif
+
+		if(!(regs.sr.var & SR_LF) || regs.lc.var <= 1 || hiword(regs.ss[dsp.ssIndex()]).var != _pc)
+			return;
+
+		const auto rx = getAddressRegX(_params);
+		const auto ry = getAddressRegY(_params);
+
+		if(regs.m[rx].var != 0xffffff || regs.m[ry].var != 0xffffff)
+			return;
+
+		// run all iterations but the last one
+		const TWord count = regs.lc.var - 1;
+
+		const TWord addrX = regs.r[rx].var;
+		const TWord addrY = regs.r[ry].var;
+
+		// reads need to stay in plain memory, no peripherals and no bridged external memory
+		auto& mem = dsp.memory();
+
+		const auto bridged = mem.getBridgedMemoryAddress();
+		const auto sizeX = bridged ? std::min(bridged, mem.size(MemArea_X)) : mem.size(MemArea_X);
+		const auto sizeY = bridged ? std::min(bridged, mem.size(MemArea_Y)) : mem.size(MemArea_Y);
+
+		if(addrX + count > sizeX || addrY + count > sizeY)
+			return;
+
+		auto& d = (_params & (1<<8)) ? regs.b : regs.a;
+		const auto negate = (_params & (1<<9)) != 0;
+
+		int64_t acc = d.signextend<int64_t>();
+
+		if(acc > g_maxAccumulator || acc < -g_maxAccumulator)
+			return;
+
+		// the first iteration multiplies the current register values, iteration i uses the words loaded by iteration i-1
+		const auto s1 = (_params & (1<<6)) ? dsp.x1() : dsp.x0();
+		const auto s2 = (_params & (1<<7)) ? dsp.y1() : dsp.y0();
+
+		const auto first = (s1.signextend<int64_t>() * s2.signextend<int64_t>()) << 1;
+		acc += negate ? -first : first;
+
+		const TWord* x = mem.getMemAreaPtr(MemArea_X) + addrX;
+		const TWord* y = mem.getMemAreaPtr(MemArea_Y) + addrY;
+
+		TWord done = 1;
+
+		while(done < count && acc <= g_maxAccumulator && acc >= -g_maxAccumulator)
+		{
+			const auto n = std::min(g_chunkSize, count - done);
+
+			const auto sum = dotProduct(x + done - 1, y + done - 1, n) << 1;
+			acc += negate ? -sum : sum;
+
+			done += n;
+		}
+
+		d.var = acc & 0x00ffffffffffffff;
+
+		if(_params & (1<<6))	dsp.x1(x[done - 1]);
+		else					dsp.x0(x[done - 1]);
+
+		if(_params & (1<<7))	dsp.y1(y[done - 1]);
+		else					dsp.y0(y[done - 1]);
+
+		regs.r[rx].var = addrX + done;
+		regs.r[ry].var = addrY + done;
+		regs.lc.var -= done;
+
+		dsp.m_instructions += done;
+
+		dsp.getJit().getStatistics().macLoopIterations += done;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "types.h"
+
+namespace dsp56k
+{
+	class DSP;
+	class Opcodes;
+
+	// A DO loop whose body is a single "mac (+/-)S1,S2,D X:(Rn)+,S1 Y:(Rm)+,S2" computes the dot product of two linear buffers
+	// in X and Y memory. The JIT block of such a loop body calls exec() on entry which runs all but the last iteration at once
+	// in a loop that the compiler can vectorize. The last iteration is done by the regular JIT code, it computes the CCR and ends the loop
+	class JitMacLoop
+	{
+	public:
+		// returns true if _op matches the pattern above, _params is passed to exec() then
+		static bool isMacLoop(TWord& _params, const Opcodes& _opcodes, TWord _op);
+
+		static TWord getAddressRegX(const TWord _params) { return _params & 7; }
+		static TWord getAddressRegY(const TWord _params) { return (_params >> 3) & 7; }
+
+		// does nothing if the loop is not running or the AGU setup or accumulator value does not allow it, the JIT block runs the iterations then
+		static void exec(DSP* _dsp, TWord _params, TWord _pc);
+	};
+}
@@ -635,18 +635,52 @@ namespace dsp56k
 		_dsp->getPeriph(_area)->write(_offset, _value);
 	}
 
+	void Jitmem::callPeriphCallback(const PeripheralRegisterAccess& _access, const DspValue& _value) const
+	{
+		const FuncArg r0(m_block, 0);
+		const FuncArg r1(m_block, 1);
+		const FuncArg r2(m_block, 2);
+
+		// value might be held in a func arg register, safe if we set the func arg for the value first
+		if (_value.isImmediate())
+		{
+			m_block.asm_().mov(r32(r2), asmjit::Imm(_value.imm()));
+		}
+		else
+		{
+			if (r32(r2) != r32(_value.get()))
+				m_block.asm_().mov(r32(r2), r32(_value.get()));
+		}
+
+		m_block.asm_().mov(r64(r0), asmjit::Imm(_access.object));
+		m_block.asm_().mov(r32(r1), asmjit::Imm(_access.index));
+
+		m_block.stack().call(asmjit::func_as_ptr(_access.callback));
+	}
+
+	void Jitmem::callPeriphCallback(const PeripheralRegisterAccess& _access, const TWord _value) const
+	{
+		callPeriphCallback(_access, DspValue(m_block, _value, DspValue::Immediate24));
+	}
+
 	void Jitmem::readPeriph(DspValue& _dst, const EMemArea _area, const TWord& _offset, const Instruction _inst) const
 	{
 		auto* periph = m_block.dsp().getPeriph(_area);
 
-		const auto* memPtr = periph->readAsPtr(_offset, _inst);
+		const auto access = periph->getReadAccess(_offset, _inst);
 
-		if(memPtr)
+		if(access.type != PeripheralRegisterAccess::Type::Dynamic)
 		{
+			++m_block.dsp().getJit().getStatistics().directPeripheralAccesses;
+
+			// the callback updates the cell, we read it afterwards
+			if(access.type == PeripheralRegisterAccess::Type::Callback)
+				callPeriphCallback(access, 0);
+
 			if (!_dst.isRegValid())
 				_dst.temp(DspValue::Memory);
 
-			mov(_dst.get(), *memPtr);
+			mov(_dst.get(), *access.cell);
 			return;
 		}
 
@@ -740,6 +774,17 @@ namespace dsp56k
 
 	void Jitmem::writePeriph(const EMemArea _area, const TWord& _offset, const DspValue& _value) const
 	{
+		const auto access = m_block.dsp().getPeriph(_area)->getWriteAccess(_offset);
+
+		if(access.type == PeripheralRegisterAccess::Type::Callback)
+		{
+			++m_block.dsp().getJit().getStatistics().directPeripheralAccesses;
+			callPeriphCallback(access, _value);
+			return;
+		}
+
+		assert(access.type == PeripheralRegisterAccess::Type::Dynamic && "peripheral register cells are read-only for JIT code");
+
 		const FuncArg r0(m_block, 0);
 		const FuncArg r1(m_block, 1);
 		const FuncArg r2(m_block, 2);
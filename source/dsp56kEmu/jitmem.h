@@ -9,6 +9,7 @@ namespace dsp56k
 {
 	class DspValue;
 	class JitBlock;
+	struct PeripheralRegisterAccess;
 
 	class Jitmem
 	{
@@ -94,6 +95,9 @@ namespace dsp56k
 
 		void writePeriph(EMemArea _area, const JitReg32& _offset, const DspValue& _value) const;
 
+		void callPeriphCallback(const PeripheralRegisterAccess& _access, const DspValue& _value) const;
+		void callPeriphCallback(const PeripheralRegisterAccess& _access, TWord _value) const;
+
 		const TWord* getMemAreaHostPtr(EMemArea _area) const;
 
 		JitBlock& m_block;
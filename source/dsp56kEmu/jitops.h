@@ -292,11 +292,16 @@ namespace dsp56k
 		void updateAddressRegisterSub(const JitReg32& _r, const JitReg32& _n, const JitReg32& _m, uint32_t _rrr, bool _addN);
 		void updateAddressRegisterSub(AddressingMode _mode, const JitReg32& _r, const JitReg32& _n, const JitReg32& _m, uint32_t _rrr, bool _addN);
 
+		// (Rn)+Nn, (Rn)-Nn and (Rn+Nn), uses immediates if the block has been specialized for the values of Nn and Mn
+		void updateAddressRegisterNn(const JitReg32& _r, const DspValue& _m, uint32_t _rrr, bool _addN);
+
 		// Parts of the AGU process
 		void updateAddressRegisterSubN1(const JitReg32& _r, const JitReg32& _m, uint32_t _rrr, bool _addN);
 		void updateAddressRegisterSubN1(AddressingMode _mode, const JitReg32& _r, const JitReg32& _m, uint32_t _rrr, bool _addN);
 		void updateAddressRegisterSubModulo(const JitReg32& _r, const JitReg32& _n, const JitReg32& _m, const JitReg32& _mMask, bool _addN) const;
 		void updateAddressRegisterSubModuloN1(const JitReg32& _r, const JitReg32& _m, const JitReg32& _mMask, bool _addN) const;
+		void updateAddressRegisterSubImm(const JitReg32& _r, TWord _n, TWord _m, TWord _mMask, bool _addN) const;
+		void updateAddressRegisterSubModuloImm(const JitReg32& _r, int32_t _step, TWord _m, TWord _mMask) const;
 		void updateAddressRegisterSubMultipleWrapModulo(const JitReg32& _r, const JitReg32& _n, const JitReg32& _mask, bool _addN);
 		void updateAddressRegisterSubMultipleWrapModuloN1(const JitReg32& _r, bool _addN, const JitReg32& _mask);
 		void updateAddressRegisterSubBitreverse(const JitReg32& _r, const JitReg32& _n, bool _addN);
@@ -1,4 +1,5 @@
 #include "jitconfig.h"
+#include "jitdspmode.h"
 #include "jitops.h"
 #include "dsp.h"
 
@@ -196,8 +197,12 @@ namespace dsp56k
 			return DspValue(m_block, JitDspRegPool::DspR0, true, false, _rrr);
 		}
 
+		// Mn is not needed if the block has been specialized for it, see updateAddressRegisterNn
+		const auto usesN = _mmm == 0 || _mmm == 1 || _mmm == 5;
+
 		DspValue m(m_block);
-		m_dspRegs.getM(m, _rrr);
+		if (!usesN || !m_block.isAguSpecialized(_rrr))
+			m_dspRegs.getM(m, _rrr);
 
 		if (_mmm == 7)													/* 111 -(Rn)   */
 		{
@@ -220,15 +225,11 @@ namespace dsp56k
 
 		if (_mmm == 5)													/* 101 (Rn+Nn) */
 		{
-			DspValue n(m_block);
-			m_dspRegs.getN(n, _rrr);
-			n.toTemp();
-
 			DspValue r(m_block);
 			r.temp(DspValue::Temp24);
 
 			m_asm.mov(r32(r.get()), r32(rRef.get()));
-			updateAddressRegisterSub(r32(r.get()), r32(n.get()), r32(m.get()), _rrr, true);
+			updateAddressRegisterNn(r32(r.get()), m, _rrr, true);
 			return DspValue(std::move(r));
 		}
 
@@ -256,17 +257,11 @@ namespace dsp56k
 
 		if (_mmm == 0)													/* 000 (Rn)-Nn */
 		{
-			DspValue n(m_block);
-			m_dspRegs.getN(n, _rrr);
-			n.toTemp();
-			updateAddressRegisterSub(r, r32(n.get()), r32(m.get()), _rrr, false);
+			updateAddressRegisterNn(r, m, _rrr, false);
 		}
 		if (_mmm == 1)													/* 001 (Rn)+Nn */
 		{
-			DspValue n(m_block);
-			m_dspRegs.getN(n, _rrr);
-			n.toTemp();
-			updateAddressRegisterSub(r, r32(n.get()), r32(m.get()), _rrr, true);
+			updateAddressRegisterNn(r, m, _rrr, true);
 		}
 		if (_mmm == 2)													/* 010 (Rn)-   */
 		{
@@ -289,6 +284,50 @@ namespace dsp56k
 		return DspValue(std::move(dst));
 	}
 
+	void JitOps::updateAddressRegisterNn(const JitReg32& _r, const DspValue& _m, const uint32_t _rrr, const bool _addN)
+	{
+		TWord nValue, mValue;
+
+		if (m_block.getSpecializedAgu(nValue, mValue, _rrr))
+		{
+			updateAddressRegisterSubImm(_r, nValue, mValue, m_block.dsp().regs().mMask[_rrr], _addN);
+			return;
+		}
+
+		DspValue n(m_block);
+		m_dspRegs.getN(n, _rrr);
+		n.toTemp();
+		updateAddressRegisterSub(_r, r32(n.get()), r32(_m.get()), _rrr, _addN);
+	}
+
+	void JitOps::updateAddressRegisterSubImm(const JitReg32& _r, const TWord _n, const TWord _m, const TWord _mMask, const bool _addN) const
+	{
+		// same as updateAddressRegisterSub but N and M are known, the block only specializes linear and modulo addressing
+		const auto mode = JitDspMode::calcAddressingMode(TReg24(_m));
+		assert(mode == AddressingMode::Linear || mode == AddressingMode::Modulo);
+
+		const auto n = static_cast<int32_t>(_n << 8) >> 8;
+		const auto step = _addN ? n : -n;
+
+		// a modulo update with a multiple of the buffer size does not wrap
+		if (mode == AddressingMode::Linear || !(_n & _mMask))
+		{
+#ifdef HAVE_ARM64
+			const RegScratch scratch(m_block);
+			m_asm.mov(r32(scratch), asmjit::Imm(step));
+			m_asm.add(_r, r32(scratch));
+#else
+			m_asm.add(_r, asmjit::Imm(step));
+#endif
+		}
+		else
+		{
+			updateAddressRegisterSubModuloImm(_r, step, _m, _mMask);
+		}
+
+		m_asm.and_(_r, asmjit::Imm(0xffffff));
+	}
+
 	void JitOps::updateAddressRegisterSubMultipleWrapModulo(const JitReg32& _r, const JitReg32& _n, const JitReg32& _mask, const bool _addN)
 	{
 		const RegScratch scratch(m_block);
@@ -221,6 +221,43 @@ namespace dsp56k
 		m_asm.csel(r, n, r, asmjit::arm::CondCode::kGT);
 	}
 
+	void JitOps::updateAddressRegisterSubModuloImm(const JitReg32& _r, const int32_t _step, const TWord _m, const TWord _mMask) const
+	{
+		const ShiftReg shift(m_block);
+		const RegScratch scratch(m_block);
+
+		const auto bound = r32(shift.get());
+		const auto p = r32(scratch);
+
+		const auto mod = static_cast<int32_t>(_m + 1);
+
+		m_asm.mov(p, asmjit::Imm(~_mMask));
+		m_asm.and_(bound, _r, p);
+
+		m_asm.mov(p, asmjit::Imm(_step));
+		m_asm.add(_r, p);
+
+		// r cannot drop below the lower bound if the step is positive
+		if(_step < 0)
+		{
+			// if (r < lowerbound)
+			//     r += mod
+			m_asm.mov(p, asmjit::Imm(mod));
+			m_asm.add(p, _r, p);
+			m_asm.cmp(_r, bound);
+			m_asm.csel(_r, p, _r, asmjit::arm::CondCode::kLT);
+		}
+
+		// if r > upperBound
+		//     r -= mod
+		m_asm.mov(p, asmjit::Imm(_m));
+		m_asm.add(bound, p);
+		m_asm.mov(p, asmjit::Imm(mod));
+		m_asm.sub(p, _r, p);
+		m_asm.cmp(_r, bound);
+		m_asm.csel(_r, p, _r, asmjit::arm::CondCode::kGT);
+	}
+
 	void JitOps::getXY0(DspValue& _dst, const uint32_t _aluIndex, bool _signextend) const
 	{
 		if(!_dst.isRegValid())
@@ -197,6 +197,39 @@ namespace dsp56k
 		m_asm.cmovg(r, n);
 	}
 
+	void JitOps::updateAddressRegisterSubModuloImm(const JitReg32& _r, const int32_t _step, const TWord _m, const TWord _mMask) const
+	{
+		const ShiftReg shift(m_block);
+		const RegScratch scratch(m_block);
+
+		const auto bound = r32(shift.get());
+		const auto p = r32(scratch);
+
+		const auto mod = static_cast<int32_t>(_m + 1);
+
+		m_asm.mov(bound, _r);
+		m_asm.and_(bound, asmjit::Imm(~_mMask));
+
+		m_asm.add(_r, asmjit::Imm(_step));
+
+		// r cannot drop below the lower bound if the step is positive
+		if(_step < 0)
+		{
+			// if (r < lowerbound)
+			//     r += mod
+			m_asm.lea(p, ptr(_r, mod));
+			m_asm.cmp(_r, bound);
+			m_asm.cmovl(_r, p);
+		}
+
+		// if r > upperBound
+		//     r -= mod
+		m_asm.add(bound, asmjit::Imm(_m));
+		m_asm.lea(p, ptr(_r, -mod));
+		m_asm.cmp(_r, bound);
+		m_asm.cmovg(_r, p);
+	}
+
 	void JitOps::getXY0(DspValue& _dst, const uint32_t _aluIndex, bool _signextend) const
 	{
 		if(!_dst.isRegValid())
@@ -0,0 +1,271 @@
+#include "jitpersistentcache.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "dsp.h"
+#include "jit.h"
+#include "jitblockruntimedata.h"
+
+namespace dsp56k
+{
+	constexpr uint64_t g_fnvOffsetBasis = 0xcbf29ce484222325ull;
+	constexpr uint64_t g_fnvPrime = 0x100000001b3ull;
+
+	static uint64_t fnv1a(uint64_t _hash, const uint32_t _value)
+	{
+		for(uint32_t i=0; i<sizeof(_value); ++i)
+		{
+			_hash ^= (_value >> (i<<3)) & 0xff;
+			_hash *= g_fnvPrime;
+		}
+		return _hash;
+	}
+
+	// the file is written field by field in little endian byte order to not depend on struct padding and host endianness
+	static void write32(std::ostream& _out, const uint32_t _value)
+	{
+		char buf[4];
+		for(uint32_t i=0; i<sizeof(buf); ++i)
+			buf[i] = static_cast<char>((_value >> (i<<3)) & 0xff);
+		_out.write(buf, sizeof(buf));
+	}
+
+	static void write64(std::ostream& _out, const uint64_t _value)
+	{
+		write32(_out, static_cast<uint32_t>(_value));
+		write32(_out, static_cast<uint32_t>(_value >> 32));
+	}
+
+	static uint32_t read32(std::istream& _in)
+	{
+		unsigned char buf[4] = {0};
+		_in.read(reinterpret_cast<char*>(buf), sizeof(buf));
+
+		uint32_t value = 0;
+		for(uint32_t i=0; i<sizeof(buf); ++i)
+			value |= static_cast<uint32_t>(buf[i]) << (i<<3);
+		return value;
+	}
+
+	static uint64_t read64(std::istream& _in)
+	{
+		const uint64_t lo = read32(_in);
+		const uint64_t hi = read32(_in);
+		return lo | (hi << 32);
+	}
+
+	JitPersistentCache::JitPersistentCache(Jit& _jit) : m_jit(_jit)
+	{
+	}
+
+	bool JitPersistentCache::save(const std::string& _filename) const
+	{
+		std::vector<Entry> entries;
+		collectEntries(entries);
+
+		std::ofstream f(_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if(!f.is_open())
+		{
+			LOG("Failed to create JIT cache file " << _filename);
+			return false;
+		}
+
+		Header header;
+		header.configHash = calcConfigHash(m_jit.getConfig());
+		header.pSize = m_jit.dsp().memory().sizeP();
+		header.entryCount = static_cast<uint32_t>(entries.size());
+
+		write32(f, header.magic);
+		write32(f, header.version);
+		write64(f, header.configHash);
+		write32(f, header.pSize);
+		write32(f, header.entryCount);
+
+		for (const auto& e : entries)
+		{
+			write32(f, e.mode);
+			write32(f, e.pc);
+			write32(f, e.memSize);
+			write32(f, e.flags);
+			write64(f, e.hash);
+		}
+
+		return f.good();
+	}
+
+	bool JitPersistentCache::load(const std::string& _filename)
+	{
+		std::ifstream f(_filename, std::ios::in | std::ios::binary);
+
+		if(!f.is_open())
+			return false;
+
+		Header header;
+		header.magic = read32(f);
+		header.version = read32(f);
+		header.configHash = read64(f);
+		header.pSize = read32(f);
+		header.entryCount = read32(f);
+
+		if(!f.good() || header.magic != Magic)
+		{
+			LOG("File " << _filename << " is not a JIT cache file");
+			return false;
+		}
+
+		if(header.version != Version)
+		{
+			LOG("JIT cache file " << _filename << " has version " << header.version << " but version " << Version << " is required, ignored");
+			return false;
+		}
+
+		if(header.configHash != calcConfigHash(m_jit.getConfig()) || header.pSize != m_jit.dsp().memory().sizeP())
+		{
+			LOG("JIT cache file " << _filename << " has been created with a different JIT config or memory size, ignored");
+			return false;
+		}
+
+		std::vector<Entry> entries;
+
+		for(uint32_t i=0; i<header.entryCount && f.good(); ++i)
+		{
+			Entry e;
+			e.mode = read32(f);
+			e.pc = read32(f);
+			e.memSize = read32(f);
+			e.flags = read32(f);
+			e.hash = read64(f);
+			entries.push_back(e);
+		}
+
+		if(!f.good())
+		{
+			LOG("JIT cache file " << _filename << " is truncated");
+			return false;
+		}
+
+		const auto count = precompile(entries);
+
+		LOG("Precompiled " << count << " of " << entries.size() << " JIT blocks from cache file " << _filename);
+
+		return true;
+	}
+
+	uint64_t JitPersistentCache::calcHash(const Memory& _mem, const TWord _pc, const TWord _size)
+	{
+		uint64_t hash = g_fnvOffsetBasis;
+
+		for(TWord i=0; i<_size; ++i)
+			hash = fnv1a(hash, _mem.get(MemArea_P, _pc + i));
+
+		return hash;
+	}
+
+	uint64_t JitPersistentCache::calcConfigHash(const JitConfig& _config)
+	{
+		uint64_t hash = g_fnvOffsetBasis;
+
+		hash = fnv1a(hash, _config.aguSupportBitreverse);
+		hash = fnv1a(hash, _config.aguSupportMultipleWrapModulo);
+		hash = fnv1a(hash, _config.cacheSingleOpBlocks);
+		hash = fnv1a(hash, _config.linkJitBlocks);
+		hash = fnv1a(hash, _config.splitOpsByNops);
+		hash = fnv1a(hash, _config.dynamicPeripheralAddressing);
+		hash = fnv1a(hash, _config.maxInstructionsPerBlock);
+		hash = fnv1a(hash, _config.memoryWritesCallCpp);
+		hash = fnv1a(hash, _config.buildSuperblocks);
+		hash = fnv1a(hash, _config.superblockMaxTakenPercent);
+		hash = fnv1a(hash, _config.keepRegistersAcrossLinkedBlocks);
+		hash = fnv1a(hash, _config.linkJitBlocksLate);
+		hash = fnv1a(hash, _config.linkSubroutineReturns);
+		hash = fnv1a(hash, _config.nativeDoLoops);
+		hash = fnv1a(hash, _config.vectorizeMacLoops);
+		hash = fnv1a(hash, _config.shareModeIndependentBlocks);
+		hash = fnv1a(hash, _config.specializeAguRegisters);
+		hash = fnv1a(hash, _config.batchInstructionCount);
+		hash = fnv1a(hash, _config.closureBlocks);
+
+		return hash;
+	}
+
+	void JitPersistentCache::collectEntries(std::vector<Entry>& _entries) const
+	{
+		const auto& mem = m_jit.dsp().memory();
+		const auto pSize = mem.sizeP();
+
+		for (const auto& it : m_jit.m_chains)
+		{
+			const auto& chain = *it.second;
+
+			for(TWord pc=0; pc<pSize; ++pc)
+			{
+				const auto* b = chain.getBlock(pc);
+
+				if(!b || b->getPCFirst() != pc)
+					continue;
+
+				Entry e;
+				e.mode = it.first.get();
+				e.pc = pc;
+				e.memSize = b->getPMemSize();
+				const auto& info = b->getInfo();
+
+				e.flags = 0;
+				if(info.loopBegin != g_invalidAddress)
+					e.flags |= LoopBegin;
+				if(info.hasFlag(JitBlockInfo::Flags::IsLoopBodyBegin) || info.terminationReason == JitBlockInfo::TerminationReason::LoopEnd)
+					e.flags |= LoopBody;
+				e.hash = calcHash(mem, pc, e.memSize);
+
+				_entries.push_back(e);
+			}
+		}
+
+		// Loop bodies are terminated at the loop end, but a loop end is only known once the block containing
+		// the DO instruction has been generated. Therefore, blocks that begin loops need to be compiled first
+		std::stable_partition(_entries.begin(), _entries.end(), [](const Entry& _e)
+		{
+			return (_e.flags & LoopBegin) != 0;
+		});
+	}
+
+	uint32_t JitPersistentCache::precompile(const std::vector<Entry>& _entries) const
+	{
+		const auto& mem = m_jit.dsp().memory();
+		const auto pSize = mem.sizeP();
+
+		uint32_t count = 0;
+
+		for (const auto& e : _entries)
+		{
+			if(e.memSize == 0 || e.pc >= pSize || e.memSize > pSize - e.pc)
+				continue;
+
+			// The first and the last block of a loop body depend on the loop that is running when they are generated.
+			// There is none at load time, they are generated once the DO instruction runs
+			if(e.flags & LoopBody)
+				continue;
+
+			// P memory might have been modified since the cache has been written, regenerate at runtime in this case
+			if(calcHash(mem, e.pc, e.memSize) != e.hash)
+				continue;
+
+			JitDspMode mode;
+			mode.initialize(e.mode);
+
+			auto* chain = m_jit.getChain(mode);
+
+			if(chain->getBlock(e.pc))
+				continue;
+
+			chain->create(e.pc, false);
+
+			if(chain->getBlock(e.pc))
+				++count;
+		}
+
+		return count;
+	}
+}
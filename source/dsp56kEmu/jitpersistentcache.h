@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace dsp56k
+{
+	class Jit;
+	class Memory;
+	struct JitConfig;
+
+	// Stores the list of JIT blocks that have been generated, keyed by a hash of the P memory words that a block covers,
+	// its DSP mode and the JIT config. When loaded, all blocks whose P memory is still identical are compiled up front,
+	// which moves the JIT warm-up out of the audio processing.
+	class JitPersistentCache
+	{
+	public:
+		static constexpr uint32_t Magic = 0x4a353644;	// 'D65J'
+		static constexpr uint32_t Version = 2;
+
+		enum EntryFlags
+		{
+			LoopBegin = 0x01,
+			LoopBody = 0x02,
+		};
+
+		struct Header
+		{
+			uint32_t magic = Magic;
+			uint32_t version = Version;
+			uint64_t configHash = 0;
+			uint32_t pSize = 0;
+			uint32_t entryCount = 0;
+		};
+
+		struct Entry
+		{
+			uint32_t mode = 0;
+			TWord pc = 0;
+			TWord memSize = 0;
+			uint32_t flags = 0;
+			uint64_t hash = 0;
+		};
+
+		explicit JitPersistentCache(Jit& _jit);
+
+		bool save(const std::string& _filename) const;
+		bool load(const std::string& _filename);
+
+		static uint64_t calcHash(const Memory& _mem, TWord _pc, TWord _size);
+		static uint64_t calcConfigHash(const JitConfig& _config);
+
+	private:
+		void collectEntries(std::vector<Entry>& _entries) const;
+		uint32_t precompile(const std::vector<Entry>& _entries) const;
+
+		Jit& m_jit;
+	};
+}
@@ -0,0 +1,129 @@
+#include "jitsingleopcache.h"
+
+#include "dspassert.h"
+
+namespace dsp56k
+{
+	constexpr uint32_t g_initialSizeLog2 = 8;
+
+	JitBlockRuntimeData* JitSingleOpCache::find(const TWord _pc, const uint64_t _key) const
+	{
+		if(!m_count)
+			return nullptr;
+
+		const auto mask = m_slots.size() - 1;
+
+		for(auto i = indexOf(_pc, _key);; i = (i + 1) & mask)
+		{
+			const auto& s = m_slots[i];
+
+			if(!s.block)
+				return nullptr;
+
+			if(s.pc == _pc && s.key == _key)
+				return s.block;
+		}
+	}
+
+	void JitSingleOpCache::add(const TWord _pc, const uint64_t _key, JitBlockRuntimeData* _block)
+	{
+		assert(_block);
+		assert(!contains(_pc, _key));
+
+		// keep the load factor at or below 50%
+		if((m_count + 1) * 2 > m_slots.size())
+			grow();
+
+		const auto mask = m_slots.size() - 1;
+
+		auto i = indexOf(_pc, _key);
+
+		while(m_slots[i].block)
+			i = (i + 1) & mask;
+
+		auto& s = m_slots[i];
+		s.pc = _pc;
+		s.key = _key;
+		s.block = _block;
+
+		++m_count;
+	}
+
+	JitBlockRuntimeData* JitSingleOpCache::remove(const TWord _pc, const uint64_t _key)
+	{
+		if(!m_count)
+			return nullptr;
+
+		const auto mask = m_slots.size() - 1;
+
+		for(auto i = indexOf(_pc, _key);; i = (i + 1) & mask)
+		{
+			const auto& s = m_slots[i];
+
+			if(!s.block)
+				return nullptr;
+
+			if(s.pc == _pc && s.key == _key)
+			{
+				auto* b = s.block;
+				removeAt(i);
+				return b;
+			}
+		}
+	}
+
+	void JitSingleOpCache::clear()
+	{
+		m_slots.clear();
+		m_count = 0;
+		m_shift = 64;
+	}
+
+	size_t JitSingleOpCache::indexOf(const TWord _pc, const uint64_t _key) const
+	{
+		// Fibonacci hashing, the upper bits of the product are the best mixed ones
+		const uint64_t h = (_key ^ (static_cast<uint64_t>(_pc) << 40) ^ _pc) * 0x9e3779b97f4a7c15ull;
+		return static_cast<size_t>(h >> m_shift);
+	}
+
+	void JitSingleOpCache::removeAt(size_t _index)
+	{
+		// backward shift deletion, no tombstones are needed this way
+		const auto mask = m_slots.size() - 1;
+
+		auto hole = _index;
+
+		for(auto i = (hole + 1) & mask; m_slots[i].block; i = (i + 1) & mask)
+		{
+			const auto home = indexOf(m_slots[i].pc, m_slots[i].key);
+
+			// the entry can be moved into the hole if the hole is located between its home slot and its current slot
+			if(((i - home) & mask) >= ((i - hole) & mask))
+			{
+				m_slots[hole] = m_slots[i];
+				hole = i;
+			}
+		}
+
+		m_slots[hole] = Slot();
+		--m_count;
+	}
+
+	void JitSingleOpCache::grow()
+	{
+		std::vector<Slot> slots;
+		slots.swap(m_slots);
+
+		const auto sizeLog2 = slots.empty() ? g_initialSizeLog2 : (64 - m_shift + 1);
+
+		m_slots.resize(static_cast<size_t>(1) << sizeLog2);
+		m_shift = 64 - sizeLog2;
+		m_count = 0;
+
+		for (const auto& s : slots)
+		{
+			if(s.block)
+				add(s.pc, s.key, s.block);
+		}
+	}
+}
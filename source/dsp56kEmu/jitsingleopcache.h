@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+namespace dsp56k
+{
+	class JitBlockRuntimeData;
+
+	// Open-addressing hash table with linear probing that stores the single-op blocks of a JIT block chain, keyed by
+	// PC and the single-op cache key of the block. Slots are stored in one flat array, there are no per-entry allocations
+	class JitSingleOpCache
+	{
+	public:
+		JitBlockRuntimeData* find(TWord _pc, uint64_t _key) const;
+		bool contains(const TWord _pc, const uint64_t _key) const { return find(_pc, _key) != nullptr; }
+
+		void add(TWord _pc, uint64_t _key, JitBlockRuntimeData* _block);
+		JitBlockRuntimeData* remove(TWord _pc, uint64_t _key);
+
+		// calls _func for all blocks at the given PC and removes the block if _func returns true
+		template<typename TFunc> void removeIf(const TWord _pc, TFunc _func)
+		{
+			for(size_t i=0; i<m_slots.size();)
+			{
+				const auto& s = m_slots[i];
+
+				if(s.block && s.pc == _pc && _func(s.block))
+					removeAt(i);	// another entry might have been moved into slot i, check it again
+				else
+					++i;
+			}
+		}
+
+		template<typename TFunc> void forEach(TFunc _func) const
+		{
+			for (const auto& s : m_slots)
+			{
+				if(s.block)
+					_func(s.block);
+			}
+		}
+
+		void clear();
+
+		size_t size() const { return m_count; }
+
+	private:
+		struct Slot
+		{
+			uint64_t key = 0;
+			TWord pc = 0;
+			JitBlockRuntimeData* block = nullptr;	// nullptr = empty slot
+		};
+
+		size_t indexOf(TWord _pc, uint64_t _key) const;
+		void removeAt(size_t _index);
+		void grow();
+
+		std::vector<Slot> m_slots;
+		size_t m_count = 0;
+		uint32_t m_shift = 64;
+	};
+}
@@ -174,14 +174,23 @@ namespace dsp56k
 		}
 	}
 
+	void JitStackHelper::popAllForEarlyReturn()
+	{
+		// restores all registers pushed so far but keeps track of them as the function continues after the early return
+		const auto pushedRegs = m_pushedRegs;
+		const auto pushedBytes = m_pushedBytes;
+
+		popAll();
+
+		m_pushedRegs = pushedRegs;
+		m_pushedBytes = pushedBytes;
+	}
+
 	void JitStackHelper::call(const void* _funcAsPtr) const
 	{
 		PushBeforeFunctionCall backup(m_block);
 
-		const auto usedSize = m_pushedBytes + g_functionCallSize;
-		const auto alignedStack = (usedSize + g_stackAlignmentBytes-1) & ~(g_stackAlignmentBytes-1);
-
-		const auto offset = alignedStack - usedSize + g_shadowSpaceSize;
+		const auto offset = callStackOffset();
 
 		stackRegSub(offset);
 
@@ -190,6 +199,31 @@ namespace dsp56k
 		stackRegAdd(offset);
 	}
 
+	void JitStackHelper::call(const JitReg64& _func) const
+	{
+		PushBeforeFunctionCall backup(m_block);
+
+		const auto offset = callStackOffset();
+
+		stackRegSub(offset);
+
+#ifdef HAVE_ARM64
+		m_block.asm_().blr(_func);
+#else
+		m_block.asm_().call(_func);
+#endif
+
+		stackRegAdd(offset);
+	}
+
+	uint64_t JitStackHelper::callStackOffset() const
+	{
+		const auto usedSize = m_pushedBytes + g_functionCallSize;
+		const auto alignedStack = (usedSize + g_stackAlignmentBytes-1) & ~(g_stackAlignmentBytes-1);
+
+		return alignedStack - usedSize + g_shadowSpaceSize;
+	}
+
 	void JitStackHelper::movePushesTo(asmjit::BaseNode* _baseNode, size_t _firstIndex)
 	{
 		m_block.asm_().setCursor(_baseNode);
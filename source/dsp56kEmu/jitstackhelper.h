@@ -32,10 +32,12 @@ namespace dsp56k
 		void pop();
 
 		void popAll();
+		void popAllForEarlyReturn();
 
 		void pushNonVolatiles();
 		
 		void call(const void* _funcAsPtr) const;
+		void call(const JitReg64& _func) const;
 
 		void movePushesTo(asmjit::BaseNode* _baseNode, size_t _firstIndex);
 
@@ -59,6 +61,7 @@ namespace dsp56k
 		void reset();
 
 	private:
+		uint64_t callStackOffset() const;
 		void stackRegAdd(uint64_t _offset) const;
 		void stackRegSub(uint64_t _offset) const;
 
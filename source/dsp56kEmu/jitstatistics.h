@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+namespace dsp56k
+{
+	struct JitStatistics
+	{
+		uint64_t interpretedInstructions = 0;	// instructions that have been run via the interpreter instead of JIT code
+		uint64_t promotedBlocks = 0;			// addresses that have been compiled after crossing the hot threshold
+		uint64_t evictionRuns = 0;				// number of times the code size exceeded JitConfig::maxCodeSize
+		uint64_t evictedBlocks = 0;				// blocks that have been released to stay within the code size budget
+		uint64_t evictedBytes = 0;				// code size of all evicted blocks
+		uint64_t sharedBlocks = 0;				// addresses that a mode chain runs via the shared chain of mode-independent blocks
+		uint64_t modeDependentBlocks = 0;		// blocks that were generated for the shared chain but turned out to depend on the DSP mode
+		uint64_t aguGuardFailures = 0;			// blocks specialized for N and M values that were entered with different ones
+		uint64_t linkedEntries = 0;				// blocks that pass DSP registers to their child and call its linked entry
+		uint64_t patchedLinks = 0;				// parents that call a child that has been compiled after them, see JitConfig::linkJitBlocksLate
+		uint64_t cyclicLinks = 0;				// parents that have not been linked to a late child because the child reaches them
+		uint64_t macLoopIterations = 0;			// DO loop iterations that have been run by JitMacLoop instead of JIT code
+		uint64_t directPeripheralAccesses = 0;	// generated peripheral register accesses that do not call IPeripherals::read() / write()
+		uint64_t sharedClosureBlocks = 0;		// closure blocks that have been taken from the JitCodeRepository instead of being created by this instance
+		uint64_t privateClosureBlocks = 0;		// P addresses whose closure blocks are not shared anymore because this instance modified them
+	};
+}
@@ -49,6 +49,8 @@ namespace dsp56k
 		rep_div();
 
 		runTest(&JitUnittests::clr_build, &JitUnittests::clr_verify);
+
+		runProgramTests();
 	}
 
 	JitUnittests::~JitUnittests()
@@ -3,6 +3,7 @@
 #include "asmjit/core/jitruntime.h"
 
 #include <functional>
+#include <vector>
 
 #include "unittests.h"
 
@@ -10,6 +11,8 @@ namespace dsp56k
 {
 	class JitBlock;
 	class JitOps;
+	struct JitConfig;
+	struct JitStatistics;
 
 	class JitUnittests : public UnitTests
 	{
@@ -17,6 +20,9 @@ namespace dsp56k
 		JitUnittests(bool _logging = true);
 		virtual ~JitUnittests();
 
+		// timings of programs with different JIT configs, called by UnitTests::runBenchmarks
+		static void runProgramBenchmarks();
+
 	private:
 		void runTest(void(JitUnittests::*_build)(), void(JitUnittests::*_verify)());
 		void runTest(const std::function<void()>& _build, const std::function<void()>& _verify) override;
@@ -73,6 +79,35 @@ namespace dsp56k
 		void clr_build();
 		void clr_verify();
 
+		// program tests, run via the JIT and via the interpreter
+		using ProgramInit = std::function<void(DSP&, uint32_t _run)>;
+
+		void runProgramTests();
+		JitStatistics verifyProgram(const std::vector<TWord>& _program, const JitConfig& _config, uint32_t _runCount = 1, const ProgramInit& _beforeRun = {});
+
+		void persistentCache();
+		void superblocks();
+		void aguGuardCCR();
+		void compileQueue();
+		void hotThreshold();
+		void singleOpCache();
+		void codeSizeBudget();
+		void sharedRuntime();
+		void aotRuntime();
+		void ccrOverwrittenByChild();
+		void linkedRegisters();
+		void lateLinking();
+		void subroutineReturns();
+		void nativeDoLoops();
+		void macLoops();
+		void sharedModeBlocks();
+		void pMemWrites();
+		void peripheralAccess();
+		void batchedInstructionCount();
+		void eventDrivenPeripherals();
+		void closureBlocks();
+		void sharedClosureBlocks();
+
 		void emit(TWord _opA, TWord _opB = 0, TWord _pc = 0) override;
 
 		asmjit::JitRuntime m_rt;
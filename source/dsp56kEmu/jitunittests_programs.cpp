@@ -0,0 +1,1034 @@
+#include "jitunittests.h"
+
+#include <chrono>
+#include <cstdio>
+
+#include "aotruntime.h"
+#include "jit.h"
+#include "jitcoderepository.h"
+#include "jitconfig.h"
+#include "timers.h"
+
+// Program tests: every program is run via the JIT and via the interpreter, each on a DSP of its own.
+// Registers, X and Y memory and the instruction counter need to be identical afterwards
+
+namespace dsp56k
+{
+	namespace
+	{
+		DefaultMemoryValidator g_programMemoryValidator;
+
+		// P addresses below Vba_End are compiled as fast interrupts, programs are placed above
+		constexpr TWord g_programBegin = 0x100;
+		constexpr TWord g_programEnd = 0x1c0;		// every program ends with a jmp to this address
+		constexpr TWord g_programMemSize = 0x200;
+
+		constexpr TWord g_jmpEnd = 0x0c0000 | g_programEnd;
+
+		// adds x0 to b while counting a down to zero
+		const std::vector<TWord> g_countdownLoop =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x56f400, 0x000040,		// move #>$40,a
+			0x20001b,				// clr b
+			0x200048,				// $105: add x0,b
+			0x200044,				// sub x0,a
+			0x0e2105,				// jne $105
+			g_jmpEnd				// jmp end
+		};
+
+		// The jeq is not taken while the branch profile is gathered, the block at $105 continues across it with a side exit.
+		// The first runs never take it, the later ones take it after some iterations of the loop
+		const std::vector<TWord> g_superblockLoop =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x56f400, 0x000010,		// move #>$10,a
+			0x20001b,				// clr b
+			0x200048,				// $105: add x0,b
+			0x20005d,				// cmp y0,b
+			0x0ea10a,				// jeq $10a
+			0x200044,				// sub x0,a
+			0x0e2105,				// jne $105
+			g_jmpEnd				// $10a: jmp end
+		};
+
+		void initSuperblockLoop(DSP& _dsp, const uint32_t _run)
+		{
+			const TWord compareValue = _run < 3 ? 0x100 : 0x5;
+			loword(_dsp.regs().y, TReg24(compareValue));
+		}
+
+		// The program rewrites the first instruction of its subroutine with x1, the subroutine has been compiled before.
+		// It also writes to a page of P memory that does not contain compiled code
+		const std::vector<TWord> g_subroutineRewrite =
+		{
+			0x60f400, 0x00010b,		// move #>$10b,r0
+			0x61f400, 0x000080,		// move #>$80,r1
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x076085,				// move x1,p:(r0)
+			0x076184,				// move x0,p:(r1)
+			0x07e187,				// move p:(r1),y1
+			0x0d010b,				// jsr $10b
+			g_jmpEnd,				// jmp end
+			0x000000,				// $10b: nop, overwritten
+			0x00000c				// rts
+		};
+
+		struct ProgramRunner
+		{
+			Peripherals56362 peripheralsX;
+			Peripherals56367 peripheralsY;
+			Memory mem;
+			DSP dsp;
+			uint64_t dispatches = 0;	// number of times that the DSP has been entered, code that is linked runs without returning
+
+			ProgramRunner(const std::vector<TWord>& _program, const JitConfig& _config, const bool _useJit)
+			: mem(g_programMemoryValidator, g_programMemSize)
+			, dsp(mem, &peripheralsX, &peripheralsY)
+			{
+				assert(g_programBegin + _program.size() <= g_programEnd);
+
+				dsp.setUseJit(_useJit);
+				dsp.getJit().setConfig(_config);
+
+				for(size_t i=0; i<_program.size(); ++i)
+					mem.set(MemArea_P, g_programBegin + static_cast<TWord>(i), _program[i]);
+			}
+
+			void run(const uint32_t _runCount, const std::function<void(DSP&, uint32_t)>& _beforeRun)
+			{
+				for(uint32_t r=0; r<_runCount; ++r)
+				{
+					// the callback may start a run at a different address
+					dsp.setPC(g_programBegin);
+
+					if(_beforeRun)
+						_beforeRun(dsp, r);
+
+					runUntil(g_programEnd);
+				}
+			}
+
+			void runUntil(const TWord _pc)
+			{
+				for(uint32_t i=0; dsp.getPC().var != _pc; ++i)
+				{
+					verify(i < 0x100000 && "program did not terminate");
+					dsp.exec();
+					++dispatches;
+				}
+			}
+		};
+
+		// Runs the program once to compile it and then _runCount times, returns DSP instructions per microsecond (MIPS)
+		double measureProgram(const std::vector<TWord>& _program, const JitConfig& _config, const uint32_t _runCount, const std::function<void(DSP&, uint32_t)>& _beforeRun = {})
+		{
+			ProgramRunner jit(_program, _config, true);
+			jit.run(1, _beforeRun);
+
+			const auto instructions = jit.dsp.getInstructionCounter();
+
+			const auto t0 = std::chrono::high_resolution_clock::now();
+			jit.run(_runCount, _beforeRun);
+			const auto t1 = std::chrono::high_resolution_clock::now();
+
+			const auto us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+
+			return static_cast<double>(jit.dsp.getInstructionCounter() - instructions) / us;
+		}
+
+		// A 16-tap FIR filter, run $800 times per program run
+		const std::vector<TWord> g_fir16 =
+		{
+			0x060088, 0x00010a,		// do #$800,$10b
+			0x60f400, 0x000000,		// move #>$0,r0
+			0x64f400, 0x000000,		// move #>$0,r4
+			0x200013,				// clr a
+			0x061080, 0x000109,		// do #$10,$10a
+			0xf098d2,				// mac y0,x0,a x:(r0)+,x0 y:(r4)+,y0
+			0x000000,				// nop
+			g_jmpEnd				// jmp end
+		};
+
+		// sums X memory with a step of n0 in a modulo buffer of 16 words
+		const std::vector<TWord> g_moduloSum =
+		{
+			0x60f400, 0x000000,		// move #>$0,r0
+			0x70f400, 0x000003,		// move #>$3,n0
+			0x05f420, 0x00000f,		// move #>$f,m0
+			0x200013,				// clr a
+			0x060088, 0x000109,		// do #$800,$10a
+			0x44c840,				// add x0,a x:(r0)+n0,x0
+			g_jmpEnd				// jmp end
+		};
+
+		// polls a peripheral register $800 times, _movep reads it into b
+		std::vector<TWord> peripheralPoll(const TWord _movep)
+		{
+			return
+			{
+				0x060088, 0x000103,		// do #$800,$104
+				_movep,
+				0x200048,				// add x0,b
+				g_jmpEnd				// jmp end
+			};
+		}
+
+		void verifyEqual(const ProgramRunner& _jit, const ProgramRunner& _interpreter)
+		{
+			const auto& j = _jit.dsp.regs();
+			const auto& i = _interpreter.dsp.regs();
+
+			verify(j.x.var == i.x.var);
+			verify(j.y.var == i.y.var);
+			verify(j.a.var == i.a.var);
+			verify(j.b.var == i.b.var);
+
+			for(size_t r=0; r<j.r.size(); ++r)
+			{
+				verify(j.r[r].var == i.r[r].var);
+				verify(j.n[r].var == i.n[r].var);
+				verify(j.m[r].var == i.m[r].var);
+			}
+
+			verify(_jit.dsp.getSR().var == _interpreter.dsp.getSR().var);
+			verify(j.omr.var == i.omr.var);
+			verify(j.pc.var == i.pc.var);
+			verify(j.la.var == i.la.var);
+			verify(j.lc.var == i.lc.var);
+			verify(j.sp.var == i.sp.var);
+			verify(j.sc.var == i.sc.var);
+
+			for(size_t s=0; s<j.ss.size(); ++s)
+				verify(j.ss[s].var == i.ss[s].var);
+
+			for(TWord a=0; a<g_programMemSize; ++a)
+			{
+				verify(_jit.mem.get(MemArea_X, a) == _interpreter.mem.get(MemArea_X, a));
+				verify(_jit.mem.get(MemArea_Y, a) == _interpreter.mem.get(MemArea_Y, a));
+			}
+
+			verify(_jit.dsp.getInstructionCounter() == _interpreter.dsp.getInstructionCounter());
+		}
+	}
+
+	void JitUnittests::runProgramTests()
+	{
+		persistentCache();
+		superblocks();
+		aguGuardCCR();
+		compileQueue();
+		hotThreshold();
+		singleOpCache();
+		codeSizeBudget();
+		sharedRuntime();
+		aotRuntime();
+		ccrOverwrittenByChild();
+		linkedRegisters();
+		lateLinking();
+		subroutineReturns();
+		nativeDoLoops();
+		macLoops();
+		sharedModeBlocks();
+		pMemWrites();
+		peripheralAccess();
+		batchedInstructionCount();
+		eventDrivenPeripherals();
+		closureBlocks();
+		sharedClosureBlocks();
+	}
+
+	JitStatistics JitUnittests::verifyProgram(const std::vector<TWord>& _program, const JitConfig& _config, const uint32_t _runCount, const ProgramInit& _beforeRun)
+	{
+		ProgramRunner interpreter(_program, _config, false);
+		interpreter.run(_runCount, _beforeRun);
+
+		ProgramRunner jit(_program, _config, true);
+		jit.run(_runCount, _beforeRun);
+
+		verifyEqual(jit, interpreter);
+
+		return jit.dsp.getJit().getStatistics();
+	}
+
+	void JitUnittests::persistentCache()
+	{
+		const std::vector<TWord> program =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200013,				// clr a
+			0x20001b,				// clr b
+			0x060380, 0x000107,		// do #3,$107
+			0x200040,				// add x0,a
+			0x200048,				// add x0,b
+			g_jmpEnd				// jmp end
+		};
+
+		JitConfig config;
+
+		const char* filename = "jitunittests.jitcache";
+
+		{
+			ProgramRunner jit(program, config, true);
+			jit.run(2, {});
+			verify(jit.dsp.getJit().savePersistentCache(filename));
+		}
+
+		ProgramRunner interpreter(program, config, false);
+		interpreter.run(2, {});
+
+		// the blocks of the loop body are not generated when loading, they depend on the loop that runs when they are generated
+		ProgramRunner jit(program, config, true);
+		const auto loaded = jit.dsp.getJit().loadPersistentCache(filename);
+		std::remove(filename);
+
+		verify(loaded);
+
+		jit.run(2, {});
+
+		verifyEqual(jit, interpreter);
+	}
+
+	void JitUnittests::superblocks()
+	{
+		JitConfig config;
+		config.hotThreshold = JitBranchProfile::MinSamples;
+		config.buildSuperblocks = true;
+
+		verifyProgram(g_superblockLoop, config, 6, initSuperblockLoop);
+	}
+
+	void JitUnittests::aguGuardCCR()
+	{
+		// The block at $102 is compiled first, while it is executed, and specializes N0. The block at $100 is compiled later and links to it.
+		// It does not compute the CCR bits of its tst that the add overwrites. Once N0 changes, the guard fails before the add has been executed
+		const std::vector<TWord> program =
+		{
+			0x200003,				// tst a
+			0x0c0102,				// jmp $102
+			0x200048,				// $102: add x0,b
+			0x204800,				// move (r0)+n0
+			g_jmpEnd				// jmp end
+		};
+
+		JitConfig config;
+		config.specializeAguRegisters = true;
+
+		const auto beforeRun = [](DSP& _dsp, const uint32_t _run)
+		{
+			if(_run < 2)
+				_dsp.setPC(0x102);
+
+			const TWord n = _run < 3 ? 1 : 2;
+			_dsp.x0(TWord(1));
+			_dsp.regs().n[0].var = n;
+		};
+
+		ProgramRunner interpreter(program, config, false);
+		interpreter.run(3, beforeRun);
+
+		ProgramRunner jit(program, config, true);
+		jit.run(3, beforeRun);
+
+		verifyEqual(jit, interpreter);
+
+		interpreter.dsp.setPC(g_programBegin);
+		beforeRun(interpreter.dsp, 3);
+
+		jit.dsp.setPC(g_programBegin);
+		beforeRun(jit.dsp, 3);
+
+		// the JIT returns to the dispatcher when the guard fails, the tst needs to be visible in the CCR at that point
+		jit.dsp.exec();
+
+		verify(jit.dsp.getJit().getStatistics().aguGuardFailures == 1);
+		verify(jit.dsp.getPC().var == 0x102);
+
+		interpreter.runUntil(0x102);
+
+		verifyEqual(jit, interpreter);
+
+		interpreter.runUntil(g_programEnd);
+		jit.runUntil(g_programEnd);
+
+		verifyEqual(jit, interpreter);
+	}
+
+	void JitUnittests::compileQueue()
+	{
+		// new code is interpreted until the queue has compiled it at a peripheral step
+		JitConfig config;
+		config.useCompileQueue = true;
+
+		const auto stats = verifyProgram(g_countdownLoop, config, 4);
+
+		verify(stats.interpretedInstructions > 0);
+	}
+
+	void JitUnittests::hotThreshold()
+	{
+		// the loop body gets hot during the first run, the code before it after four runs
+		JitConfig config;
+		config.hotThreshold = 4;
+
+		const auto stats = verifyProgram(g_countdownLoop, config, 6);
+
+		verify(stats.interpretedInstructions > 0);
+		verify(stats.promotedBlocks > 0);
+
+		// addresses stay hot when their blocks are evicted, they are compiled again without being interpreted another time
+		config.maxCodeSize = 1;
+
+		const auto evictedStats = verifyProgram(g_countdownLoop, config, 6);
+
+		verify(evictedStats.evictedBlocks > 0);
+		verify(evictedStats.interpretedInstructions == stats.interpretedInstructions);
+		verify(evictedStats.promotedBlocks == stats.promotedBlocks);
+	}
+
+	void JitUnittests::singleOpCache()
+	{
+		// The instruction at $105 is rewritten by the program itself and alternates between two opcodes.
+		// It ends up as a single-op block that is moved to the single-op cache when it is overwritten and taken from there later
+		const std::vector<TWord> program =
+		{
+			0x60f400, 0x000105,		// move #>$105,r0
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x076085,				// move x1,p:(r0)
+			0x000000,				// $105: nop, overwritten
+			g_jmpEnd				// jmp end
+		};
+
+		JitConfig config;
+		config.cacheSingleOpBlocks = true;
+
+		verifyProgram(program, config, 8, [](DSP& _dsp, const uint32_t _run)
+		{
+			const TWord op = (_run & 1) ? 0x200048 : 0x200040;	// add x0,b / add x0,a
+			_dsp.x1(op);
+		});
+	}
+
+	void JitUnittests::codeSizeBudget()
+	{
+		// every block exceeds the budget, blocks are evicted at each peripheral step and compiled again when they are run
+		JitConfig config;
+		config.maxCodeSize = 1;
+
+		const auto stats = verifyProgram(g_countdownLoop, config, 4);
+
+		verify(stats.evictionRuns > 0);
+		verify(stats.evictedBlocks > 0);
+	}
+
+	void JitUnittests::sharedRuntime()
+	{
+		// two DSPs allocate their code from the same runtime, runs are interleaved
+		JitConfig config;
+		config.shareJitRuntime = true;
+
+		ProgramRunner interpreter(g_countdownLoop, config, false);
+		interpreter.run(2, {});
+
+		ProgramRunner jitA(g_countdownLoop, config, true);
+		ProgramRunner jitB(g_countdownLoop, config, true);
+
+		for(uint32_t i=0; i<2; ++i)
+		{
+			jitA.run(1, {});
+			jitB.run(1, {});
+		}
+
+		verify(jitA.dsp.getJit().getRuntime() == jitB.dsp.getJit().getRuntime());
+
+		verifyEqual(jitA, interpreter);
+		verifyEqual(jitB, interpreter);
+	}
+
+	void JitUnittests::aotRuntime()
+	{
+		// everything that is reachable from the program start is compiled before the program runs, the loop body is compiled once the loop runs
+		const std::vector<TWord> program =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200013,				// clr a
+			0x0d0109,				// jsr $109
+			0x060380, 0x000107,		// do #3,$107
+			0x200040,				// add x0,a
+			0x200048,				// add x0,b
+			g_jmpEnd,				// jmp end
+			0x20001b,				// $109: clr b
+			0x00000c				// rts
+		};
+
+		// the loop body consists of two blocks, the last one ends at LA and is compiled once the loop runs, too
+		const std::vector<TWord> multiBlockLoop =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200013,				// clr a
+			0x060380, 0x000108,		// do #3,$109
+			0x200040,				// add x0,a
+			0x0c0107,				// jmp $107
+			0x200048,				// $107: add x0,b
+			0x200040,				// add x0,a
+			g_jmpEnd				// jmp end
+		};
+
+		JitConfig config;
+
+		for (const auto* p : {&program, &multiBlockLoop})
+		{
+			ProgramRunner interpreter(*p, config, false);
+			interpreter.run(2, {});
+
+			ProgramRunner jit(*p, config, true);
+			jit.dsp.setPC(g_programBegin);
+
+			AotRuntime aot(jit.dsp);
+			verify(aot.analyze() > 0);
+			verify(aot.compile() > 0);
+
+			jit.run(2, {});
+
+			verifyEqual(jit, interpreter);
+		}
+	}
+
+	void JitUnittests::ccrOverwrittenByChild()
+	{
+		// The tst of the child overwrites E, N, U and Z of the cmp of the parent, C and V need to be computed by the parent nevertheless
+		const std::vector<TWord> program =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200045,				// cmp x0,a
+			0x0c0104,				// jmp $104
+			0x20000b,				// $104: tst b
+			g_jmpEnd				// jmp end
+		};
+
+		JitConfig config;
+
+		verifyProgram(program, config, 3, [](DSP& _dsp, const uint32_t _run)
+		{
+			_dsp.regs().a.var = _run;
+			_dsp.regs().b.var = _run == 1 ? 0 : 0x00ff000000000000;
+		});
+	}
+
+	void JitUnittests::linkedRegisters()
+	{
+		// r0, x0 and a are passed from block to block
+		const std::vector<TWord> program =
+		{
+			0x60f400, 0x000010,		// move #>$10,r0
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200013,				// clr a
+			0x0c0106,				// jmp $106
+			0x200040,				// $106: add x0,a
+			0x565800,				// move a,x:(r0)+
+			0x0c0109,				// jmp $109
+			0x200040,				// $109: add x0,a
+			0x565800,				// move a,x:(r0)+
+			g_jmpEnd				// jmp end
+		};
+
+		JitConfig config;
+
+		verify(verifyProgram(program, config, 3).linkedEntries == 0);
+
+		config.keepRegistersAcrossLinkedBlocks = true;
+
+		verify(verifyProgram(program, config, 3).linkedEntries > 0);
+		verifyProgram(g_countdownLoop, config, 3);
+	}
+
+	void JitUnittests::lateLinking()
+	{
+		// Blocks end after two instructions and code is compiled once it ran twice. Parents are compiled before their children
+		// and call them once they exist
+		JitConfig config;
+		config.linkJitBlocksLate = true;
+		config.maxInstructionsPerBlock = 2;
+		config.hotThreshold = 2;
+
+		const std::vector<TWord> program =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200013,				// clr a
+			0x200040,				// add x0,a
+			0x200040,				// add x0,a
+			0x200048,				// add x0,b
+			0x200048,				// add x0,b
+			g_jmpEnd				// jmp end
+		};
+
+		const auto stats = verifyProgram(program, config, 4);
+
+		verify(stats.patchedLinks > 0);
+		verify(stats.cyclicLinks == 0);
+
+		// The block at $105 is compiled first, its late child at $107 branches back to it. If it was linked, each loop
+		// iteration would be a nested native call
+		const auto loopStats = verifyProgram(g_countdownLoop, config, 4);
+
+		verify(loopStats.cyclicLinks > 0);
+	}
+
+	void JitUnittests::subroutineReturns()
+	{
+		// the subroutine returns to three different addresses
+		const std::vector<TWord> program =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200013,				// clr a
+			0x0d0108,				// jsr $108
+			0x0d0108,				// jsr $108
+			0x200048,				// add x0,b
+			0x0d0108,				// jsr $108
+			g_jmpEnd,				// jmp end
+			0x200040,				// $108: add x0,a
+			0x00000c				// rts
+		};
+
+		JitConfig config;
+
+		ProgramRunner interpreter(program, config, false);
+		interpreter.run(3, {});
+
+		auto runJit = [&](const bool _linkReturns)
+		{
+			config.linkSubroutineReturns = _linkReturns;
+
+			ProgramRunner jit(program, config, true);
+			jit.run(3, {});
+
+			verifyEqual(jit, interpreter);
+
+			return jit.dispatches;
+		};
+
+		// the code following each jsr runs without returning to the dispatcher once it has been compiled
+		verify(runJit(true) < runJit(false));
+	}
+
+	void JitUnittests::nativeDoLoops()
+	{
+		JitConfig config;
+		config.nativeDoLoops = true;
+
+		// the loop body is one block and runs as a native loop
+		const std::vector<TWord> loop =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200013,				// clr a
+			0x20001b,				// clr b
+			0x064080, 0x000107,		// do #$40,$107
+			0x200040,				// add x0,a
+			0x200048,				// add x0,b
+			g_jmpEnd				// jmp end
+		};
+
+		verifyProgram(loop, config, 3);
+
+		// the inner loop body is a native loop, the outer body needs to end it and continue with the outer loop
+		const std::vector<TWord> nested =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200013,				// clr a
+			0x20001b,				// clr b
+			0x060480, 0x000109,		// do #4,$109
+			0x061080, 0x000108,		// do #$10,$108
+			0x200040,				// $108: add x0,a
+			0x200048,				// $109: add x0,b
+			g_jmpEnd				// jmp end
+		};
+
+		verifyProgram(nested, config, 3);
+	}
+
+	void JitUnittests::macLoops()
+	{
+		// A dot product of $1f0 elements. The products of the first runs sum up to more than 56 bits, the kernel needs to stop
+		// at the accumulator bound and leave the rest to the regular code. The last run stays just below the bound
+		const std::vector<TWord> program =
+		{
+			0x60f400, 0x000000,		// move #>$0,r0
+			0x64f400, 0x000000,		// move #>$0,r4
+			0x200013,				// clr a
+			0x06f081, 0x000107,		// do #$1f0,$107
+			0xf098d2,				// mac y0,x0,a x:(r0)+,x0 y:(r4)+,y0
+			g_jmpEnd				// jmp end
+		};
+
+		JitConfig config;
+		config.vectorizeMacLoops = true;
+
+		const auto stats = verifyProgram(program, config, 4, [](DSP& _dsp, const uint32_t _run)
+		{
+			constexpr TWord values[][2] = {{0x7fffff, 0x7fffff}, {0x7fffff, 0x800000}, {0x000123, 0xfff456}, {0x400000, 0x400000}};
+
+			for(TWord i=0; i<0x1f0; ++i)
+			{
+				// alternate signs in the third run
+				const TWord x = values[_run][0];
+				const TWord y = _run == 2 && (i & 1) ? (~values[_run][1] + 1) & 0xffffff : values[_run][1];
+
+				_dsp.memory().set(MemArea_X, i, x);
+				_dsp.memory().set(MemArea_Y, i, y);
+			}
+		});
+
+		verify(stats.macLoopIterations > 0);
+
+		// Cases on both sides of each bound that makes the kernel leave all iterations to the JIT code. _prefix is run before the loop
+		auto kernelIterations = [this, &config](const std::vector<TWord>& _prefix, const std::function<void(DSP&)>& _init)
+		{
+			auto program = _prefix;
+			const auto loopEnd = g_programBegin + static_cast<TWord>(program.size()) + 2;
+			program.insert(program.end(),
+			{
+				0x061080, loopEnd,		// do #$10,loopEnd+1
+				0xf098d2,				// mac y0,x0,a x:(r0)+,x0 y:(r4)+,y0
+				g_jmpEnd				// jmp end
+			});
+
+			return verifyProgram(program, config, 2, [&](DSP& _dsp, uint32_t)
+			{
+				for(TWord i=0; i<0x100; ++i)
+				{
+					_dsp.memory().set(MemArea_X, i, i + 1);
+					_dsp.memory().set(MemArea_Y, i, 0x010000);
+				}
+				_dsp.regs().r[0].var = 0;
+				_dsp.regs().r[4].var = 0;
+				_dsp.regs().a.var = 0;
+
+				_init(_dsp);
+			}).macLoopIterations;
+		};
+
+		// accumulator magnitude of 2^54 and above, products are zero
+		auto initAccumulator = [](const uint64_t _a)
+		{
+			return [_a](DSP& _dsp)
+			{
+				for(TWord i=0; i<0x100; ++i)
+					_dsp.memory().set(MemArea_X, i, 0);
+				_dsp.x0(0);
+				_dsp.regs().a.var = _a & 0x00ffffffffffffff;
+			};
+		};
+
+		constexpr uint64_t maxAccumulator = 1ull << 54;
+
+		verify(kernelIterations({}, initAccumulator(maxAccumulator)) > 0);
+		verify(kernelIterations({}, initAccumulator(maxAccumulator + 1)) == 0);
+		verify(kernelIterations({}, initAccumulator(~maxAccumulator + 1)) > 0);
+		verify(kernelIterations({}, initAccumulator(~(maxAccumulator + 1) + 1)) == 0);
+
+		// modulo addressing
+		verify(kernelIterations({0x05f420, 0xffffff}, [](DSP&) {}) > 0);	// move #>$ffffff,m0
+		verify(kernelIterations({0x05f420, 0x00000f}, [](DSP&) {}) == 0);	// move #>$f,m0
+
+		// X memory from $100 on is bridged to P memory. The last word that the kernel reads needs to be in X memory
+		auto initBridged = [](const TWord _r0)
+		{
+			return [_r0](DSP& _dsp)
+			{
+				_dsp.memory().setExternalMemory(0x100, true);
+				_dsp.regs().r[0].var = _r0;
+			};
+		};
+
+		verify(kernelIterations({}, initBridged(0xf1)) > 0);
+		verify(kernelIterations({}, initBridged(0xf2)) == 0);
+	}
+
+	void JitUnittests::sharedModeBlocks()
+	{
+		// the subroutine is called with two different values of m0, both mode chains run the same shared block
+		const std::vector<TWord> program =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200013,				// clr a
+			0x0d010a,				// jsr $10a
+			0x05f420, 0x000003,		// move #>$3,m0
+			0x0d010a,				// jsr $10a
+			0x05f420, 0xffffff,		// move #>$ffffff,m0
+			g_jmpEnd,				// jmp end
+			0x200040,				// $10a: add x0,a
+			0x00000c				// rts
+		};
+
+		JitConfig config;
+		config.shareModeIndependentBlocks = true;
+
+		const auto stats = verifyProgram(program, config, 3);
+
+		verify(stats.sharedBlocks > 0);
+	}
+
+	void JitUnittests::pMemWrites()
+	{
+		JitConfig config;
+
+		verifyProgram(g_subroutineRewrite, config, 6, [](DSP& _dsp, const uint32_t _run)
+		{
+			const TWord op = (_run & 1) ? 0x200048 : 0x200040;	// add x0,b / add x0,a
+			_dsp.x1(op);
+		});
+	}
+
+	void JitUnittests::peripheralAccess()
+	{
+		// Timer registers are written via the peripherals and read from their memory cells, HCR is a memory cell as well and
+		// SAISR is read via a callback
+		const std::vector<TWord> program =
+		{
+			0x44f400, 0x001234,		// move #>$1234,x0
+			0x447000, 0xffff8e,		// move x0,x:$ffff8e (TLR0)
+			0x45f000, 0xffff8e,		// move x:$ffff8e,x1
+			0x447000, 0xffff8d,		// move x0,x:$ffff8d (TCPR0)
+			0x56f000, 0xffff8d,		// move x:$ffff8d,a
+			0x084f02,				// movep x:$ffffc2,b (HCR)
+			0x46f000, 0xffffb3,		// move x:$ffffb3,y0 (SAISR)
+			g_jmpEnd				// jmp end
+		};
+
+		JitConfig config;
+
+		const auto stats = verifyProgram(program, config, 2);
+
+		verify(stats.directPeripheralAccesses > 0);
+	}
+
+	void JitUnittests::batchedInstructionCount()
+	{
+		// the superblock counts all of its instructions on entry, the taken side exit needs to subtract the ones that did not run
+		JitConfig config;
+		config.hotThreshold = JitBranchProfile::MinSamples;
+		config.buildSuperblocks = true;
+		config.batchInstructionCount = true;
+
+		verifyProgram(g_superblockLoop, config, 6, initSuperblockLoop);
+	}
+
+	void JitUnittests::eventDrivenPeripherals()
+	{
+		// peripheral steps are further apart, the compile queue is processed at these steps only
+		JitConfig config;
+		config.useCompileQueue = true;
+
+		const auto stats = verifyProgram(g_countdownLoop, config, 4, [](DSP& _dsp, uint32_t)
+		{
+			_dsp.setEventDrivenPeripherals(true);
+		});
+
+		verify(stats.interpretedInstructions > 0);
+
+		// Enabling a timer brings the next peripheral step forward to its compare event. The compare flag is seen at the
+		// same instruction as with fixed steps if the event is on a step, otherwise earlier, but never later
+		auto timerCompareSeenAfter = [&config](const bool _eventDriven, const TWord _compareValue)
+		{
+			ProgramRunner r({0x0c0000 | g_programBegin}, config, false);	// jmp to itself
+			r.dsp.setEventDrivenPeripherals(_eventDriven);
+			r.dsp.setPC(g_programBegin);
+
+			for(size_t i=0; i<3; ++i)
+				r.dsp.exec();
+
+			r.peripheralsX.write(Timers::M_TCPR0, _compareValue);
+			r.peripheralsX.write(Timers::M_TCSR0, 1 << Timer::M_TE);
+
+			if(_eventDriven)
+				verify(r.dsp.getRemainingPeripheralsCycles() <= (_compareValue << 1));
+
+			const auto start = r.dsp.getInstructionCounter();
+
+			while(!(r.peripheralsX.read(Timers::M_TCSR0, Nop) & (1 << Timer::M_TCF)))
+			{
+				verify(r.dsp.getInstructionCounter() - start < 0x10000);
+				r.dsp.exec();
+			}
+
+			return r.dsp.getInstructionCounter() - start;
+		};
+
+		verify(timerCompareSeenAfter(true, 0x40) == timerCompareSeenAfter(false, 0x40));
+
+		const auto eventDriven = timerCompareSeenAfter(true, 0x41);
+		const auto stepped = timerCompareSeenAfter(false, 0x41);
+
+		verify(eventDriven < stepped);
+		verify(stepped - eventDriven < DSP::PeripheralsProcessingStepSize);
+	}
+
+	void JitUnittests::closureBlocks()
+	{
+		JitConfig config;
+		config.closureBlocks = true;
+
+		verifyProgram(g_countdownLoop, config, 3);
+
+		// nested DO loops, the blocks handle the loop ends instead of the interpreter running the body recursively
+		verifyProgram(g_fir16, config, 2);
+		verifyProgram(g_moduloSum, config, 2);
+
+		// the op that is repeated runs as part of the REP
+		const std::vector<TWord> rep =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x200013,				// clr a
+			0x0610a0,				// rep #$10
+			0x200040,				// add x0,a
+			0x200048,				// add x0,b
+			g_jmpEnd				// jmp end
+		};
+
+		verifyProgram(rep, config, 3);
+
+		// the block rewrites its own first op while it is running
+		const std::vector<TWord> selfModifying =
+		{
+			0x200040,				// $100: add x0,a, overwritten
+			0x60f400, 0x000100,		// move #>$100,r0
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x076085,				// move x1,p:(r0)
+			g_jmpEnd				// jmp end
+		};
+
+		verifyProgram(selfModifying, config, 4, [](DSP& _dsp, const uint32_t _run)
+		{
+			const TWord op = (_run & 1) ? 0x200048 : 0x200040;	// add x0,b / add x0,a
+			_dsp.x1(op);
+		});
+
+		// a block is left at a taken side exit
+		config.hotThreshold = JitBranchProfile::MinSamples;
+		config.buildSuperblocks = true;
+
+		verifyProgram(g_superblockLoop, config, 6, initSuperblockLoop);
+
+		// the mode chain forwards to the block of the shared chain
+		config = JitConfig();
+		config.closureBlocks = true;
+		config.shareModeIndependentBlocks = true;
+
+		verify(verifyProgram(g_countdownLoop, config, 3).sharedBlocks > 0);
+	}
+
+	void JitUnittests::sharedClosureBlocks()
+	{
+		// two DSPs run the blocks that the first one has created, runs are interleaved
+		JitConfig config;
+		config.closureBlocks = true;
+		config.shareClosureBlocks = true;
+
+		for (const auto* p : {&g_countdownLoop, &g_fir16})
+		{
+			ProgramRunner interpreter(*p, config, false);
+			interpreter.run(2, {});
+
+			ProgramRunner jitA(*p, config, true);
+			ProgramRunner jitB(*p, config, true);
+
+			for(uint32_t i=0; i<2; ++i)
+			{
+				jitA.run(1, {});
+				jitB.run(1, {});
+			}
+
+			verify(JitCodeRepository::size() > 0);
+			verify(jitA.dsp.getJit().getStatistics().sharedClosureBlocks == 0);
+			verify(jitB.dsp.getJit().getStatistics().sharedClosureBlocks > 0);
+
+			verifyEqual(jitA, interpreter);
+			verifyEqual(jitB, interpreter);
+		}
+
+		// blocks are removed with the last instance that runs them
+		verify(JitCodeRepository::size() == 0);
+
+		// both DSPs rewrite the subroutine with different ops, each one continues with private blocks there
+		const auto rewrite = [](DSP& _dsp, const uint32_t _run)
+		{
+			const TWord op = (_run & 1) ? 0x200048 : 0x200040;	// add x0,b / add x0,a
+			_dsp.x1(op);
+		};
+
+		ProgramRunner interpreterA(g_subroutineRewrite, config, false);
+		ProgramRunner interpreterB(g_subroutineRewrite, config, false);
+
+		interpreterA.run(6, rewrite);
+		interpreterB.run(6, [&](DSP& _dsp, const uint32_t _run) { rewrite(_dsp, _run + 1); });
+
+		ProgramRunner jitA(g_subroutineRewrite, config, true);
+		ProgramRunner jitB(g_subroutineRewrite, config, true);
+
+		for(uint32_t r=0; r<6; ++r)
+		{
+			jitA.run(1, [&](DSP& _dsp, uint32_t) { rewrite(_dsp, r); });
+			jitB.run(1, [&](DSP& _dsp, uint32_t) { rewrite(_dsp, r + 1); });
+		}
+
+		verify(jitB.dsp.getJit().getStatistics().sharedClosureBlocks > 0);
+		verify(jitA.dsp.getJit().getStatistics().privateClosureBlocks > 0);
+		verify(jitB.dsp.getJit().getStatistics().privateClosureBlocks > 0);
+
+		verifyEqual(jitA, interpreterA);
+		verifyEqual(jitB, interpreterB);
+	}
+
+	void JitUnittests::runProgramBenchmarks()
+	{
+		JitConfig config;
+
+		const auto firLoops = measureProgram(g_fir16, config, 50);
+		config.nativeDoLoops = true;
+		const auto firNative = measureProgram(g_fir16, config, 50);
+
+		LOG("16-tap FIR: " << firLoops << " MIPS, with nativeDoLoops: " << firNative << " MIPS");
+
+		config = JitConfig();
+		config.vectorizeMacLoops = true;
+		const auto firKernel = measureProgram(g_fir16, config, 50);
+
+		LOG("16-tap FIR with vectorizeMacLoops: " << firKernel << " MIPS");
+
+		config = JitConfig();
+		const auto moduloGeneric = measureProgram(g_moduloSum, config, 50);
+		config.specializeAguRegisters = true;
+		const auto moduloSpecialized = measureProgram(g_moduloSum, config, 50);
+
+		LOG("Modulo (r0)+n0 loop: " << moduloGeneric << " MIPS, with specializeAguRegisters: " << moduloSpecialized << " MIPS");
+
+		// HCR is a memory cell and HSR a cell updated by a callback, both go through IPeripherals with dynamicPeripheralAddressing
+		config = JitConfig();
+		const auto hcrDirect = measureProgram(peripheralPoll(0x084f02), config, 50);	// movep x:$ffffc2,b
+		const auto hsrDirect = measureProgram(peripheralPoll(0x084f03), config, 50);	// movep x:$ffffc3,b
+		config.dynamicPeripheralAddressing = true;
+		const auto hcrDynamic = measureProgram(peripheralPoll(0x084f02), config, 50);
+		const auto hsrDynamic = measureProgram(peripheralPoll(0x084f03), config, 50);
+
+		LOG("HCR poll: " << hcrDirect << " MIPS, with dynamicPeripheralAddressing: " << hcrDynamic << " MIPS");
+		LOG("HSR poll: " << hsrDirect << " MIPS, with dynamicPeripheralAddressing: " << hsrDynamic << " MIPS");
+
+		// the superblock loop with $800 iterations, the jeq is never taken
+		auto superblockLoop = g_superblockLoop;
+		superblockLoop[3] = 0x000800;
+
+		const auto initLongSuperblockLoop = [](DSP& _dsp, uint32_t)
+		{
+			loword(_dsp.regs().y, TReg24(0x1000));
+		};
+
+		config = JitConfig();
+		config.hotThreshold = JitBranchProfile::MinSamples;
+		config.buildSuperblocks = true;
+		const auto superblockCounted = measureProgram(superblockLoop, config, 50, initLongSuperblockLoop);
+		config.batchInstructionCount = true;
+		const auto superblockBatched = measureProgram(superblockLoop, config, 50, initLongSuperblockLoop);
+
+		LOG("Superblock loop: " << superblockCounted << " MIPS, with batchInstructionCount: " << superblockBatched << " MIPS");
+	}
+}
@@ -208,6 +208,13 @@ namespace dsp56k
 #endif
 	}
 
+	const OpcodeAnalysis& Memory::getOpcodeAnalysis(const TWord _offset) const
+	{
+		TWord opA, opB;
+		getOpcode(_offset, opA, opB);
+		return m_opcodeAnalysis.get(m_dsp->opcodes(), _offset, opA, opB);
+	}
+
 	// _____________________________________________________________________________
 	// loadOMF
 	//
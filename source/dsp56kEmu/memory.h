@@ -4,6 +4,7 @@
 #include <set>
 #include <vector>
 
+#include "opcodeanalysiscache.h"
 #include "peripherals.h"
 
 namespace dsp56k
@@ -84,6 +85,8 @@ namespace dsp56k
 
 		std::map<char, std::map<TWord, SSymbol>> m_symbols;
 
+		mutable OpcodeAnalysisCache	m_opcodeAnalysis;
+
 		// _____________________________________________________________________________
 		// implementation
 		//
@@ -101,6 +104,9 @@ namespace dsp56k
 		TWord				get					( EMemArea _area, TWord _offset ) const;
 		void				getOpcode			( TWord _offset, TWord& _wordA, TWord& _wordB ) const;
 
+		// decoded instruction at a P address, requires setDSP() to be called first
+		const OpcodeAnalysis& getOpcodeAnalysis	( TWord _offset ) const;
+
 		bool				save				(const char* _file, EMemArea _area) const;
 		bool				saveAssembly		(const char* _file, TWord _offset, const TWord _count, bool _skipNops = true, bool _skipDC = false, IPeripherals* _peripheralsX = nullptr, IPeripherals* _peripheralsY = nullptr) const;
 
@@ -0,0 +1,48 @@
+#include "opcodeanalysiscache.h"
+
+#include "opcodeanalysis.h"
+#include "opcodes.h"
+
+namespace dsp56k
+{
+	const OpcodeAnalysis& OpcodeAnalysisCache::get(const Opcodes& _opcodes, const TWord _pc, const TWord _opA, const TWord _opB)
+	{
+		const auto pageIndex = _pc >> PageBits;
+
+		if(pageIndex >= m_pages.size())
+			m_pages.resize(pageIndex + 1);
+
+		auto& page = m_pages[pageIndex];
+
+		if(!page)
+			page.reset(new Page());
+
+		auto& entry = (*page)[_pc & (PageSize - 1)];
+
+		if(!entry.valid || entry.opA != _opA || entry.opB != _opB)
+			analyze(entry, _opcodes, _pc, _opA, _opB);
+
+		return entry;
+	}
+
+	void OpcodeAnalysisCache::analyze(OpcodeAnalysis& _dst, const Opcodes& _opcodes, const TWord _pc, const TWord _opA, const TWord _opB)
+	{
+		_dst.opA = _opA;
+		_dst.opB = _opB;
+
+		_opcodes.getInstructionTypes(_opA, _dst.instA, _dst.instB);
+		_opcodes.getRegisters(_dst.written, _dst.read, _opA, _opB);
+
+		_dst.length = _opcodes.getOpcodeLength(_opA, _dst.instA, _dst.instB);
+		_dst.flags = Opcodes::getFlags(_dst.instA, _dst.instB);
+
+		_dst.branchTarget = _dst.instA != Invalid ? getBranchTarget(_dst.instA, _opA, _opB, _pc) : g_invalidAddress;
+
+		if(!getLoopEndAddr(_dst.loopEnd, _dst.instA, _pc, _opB))
+			_dst.loopEnd = g_invalidAddress;
+
+		_dst.writesPMem = writesToPMemory(_dst.instA, _opA) || writesToPMemory(_dst.instB, _opA);
+
+		_dst.valid = true;
+	}
+}
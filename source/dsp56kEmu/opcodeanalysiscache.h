@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "opcodetypes.h"
+#include "types.h"
+
+namespace dsp56k
+{
+	enum class RegisterMask : uint64_t;
+
+	class Opcodes;
+
+	// decoded properties of the instruction at one P memory address
+	struct OpcodeAnalysis
+	{
+		TWord opA = 0;
+		TWord opB = 0;
+
+		Instruction instA = Invalid;
+		Instruction instB = Invalid;
+
+		uint32_t length = 0;
+		uint32_t flags = 0;
+
+		RegisterMask written{};
+		RegisterMask read{};
+
+		TWord branchTarget = 0;		// g_invalidAddress if not a branch, g_dynamicAddress if the target is a register
+		TWord loopEnd = 0;			// first address after the loop body if this is a DO/DOR, g_invalidAddress otherwise
+
+		bool writesPMem = false;
+		bool valid = false;
+	};
+
+	// Per-address cache of OpcodeAnalysis for P memory, filled on first access. An entry remembers the opcode words it was
+	// created from and is analyzed again if P memory holds different words now. This covers every way of modifying P memory,
+	// including bridged external memory writes done by JIT code and writes via Memory::getMemAreaPtr
+	class OpcodeAnalysisCache
+	{
+	public:
+		static constexpr TWord PageBits = 8;
+		static constexpr TWord PageSize = 1 << PageBits;
+
+		const OpcodeAnalysis& get(const Opcodes& _opcodes, TWord _pc, TWord _opA, TWord _opB);
+
+		void clear() { m_pages.clear(); }
+
+		static void analyze(OpcodeAnalysis& _dst, const Opcodes& _opcodes, TWord _pc, TWord _opA, TWord _opB);
+
+	private:
+		using Page = std::array<OpcodeAnalysis, PageSize>;
+
+		std::vector<std::unique_ptr<Page>> m_pages;
+	};
+}
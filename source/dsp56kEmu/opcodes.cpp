@@ -59,24 +59,70 @@ namespace dsp56k
 			else if(hasField(opcode, Field_MoveOperation))
 				m_opcodesAlu.push_back(&opcode);
 		}
+
+		// the lists are equal for all instances, build the tables only once
+		static const OpcodeDecodeTables decodeTables(m_opcodesNonParallel, m_opcodesMove, m_opcodesAlu);
+		m_decodeTables = &decodeTables;
+	}
+
+	OpcodeDecodeTable::OpcodeDecodeTable(const uint32_t _shift, const uint32_t _bitCount, const std::vector<const OpcodeInfo*>& _opcodes)
+		: m_shift(_shift)
+		, m_mask((1 << _bitCount) - 1)
+	{
+		const auto keyBits = m_mask << m_shift;
+
+		m_bucketOffsets.reserve(m_mask + 2);
+
+		for(TWord key=0; key<=m_mask; ++key)
+		{
+			m_bucketOffsets.push_back(static_cast<uint32_t>(m_candidates.size()));
+
+			const auto bits = key << m_shift;
+
+			// an opcode is a candidate if none of its fixed bits contradicts the key
+			for (const auto* oi : _opcodes)
+			{
+				const auto fixedBits = (oi->m_mask0 | oi->m_mask1) & keyBits;
+
+				if(((bits ^ oi->m_mask1) & fixedBits) == 0)
+					m_candidates.push_back(oi);
+			}
+		}
+
+		m_bucketOffsets.push_back(static_cast<uint32_t>(m_candidates.size()));
+	}
+
+	const OpcodeInfo* OpcodeDecodeTable::find(const TWord _opcode) const
+	{
+		const auto key = (_opcode >> m_shift) & m_mask;
+		const auto* candidates = m_candidates.data();
+
+		return Opcodes::findOpcodeInfo(_opcode, candidates + m_bucketOffsets[key], candidates + m_bucketOffsets[key + 1]);
+	}
+
+	OpcodeDecodeTables::OpcodeDecodeTables(const std::vector<const OpcodeInfo*>& _nonParallel, const std::vector<const OpcodeInfo*>& _move, const std::vector<const OpcodeInfo*>& _alu)
+		: nonParallel(8, 12, _nonParallel)	// bits 23-20 are zero for non-parallel opcodes
+		, move(8, 16, _move)				// the low byte is the ALU operation
+		, alu(0, 8, _alu)					// ALU operations only use the low byte
+	{
 	}
 
 	const OpcodeInfo* Opcodes::findNonParallelOpcodeInfo(TWord _opcode) const
 	{
 		assert(isNonParallelOpcode(_opcode));
-		return findOpcodeInfo(_opcode, m_opcodesNonParallel);
+		return m_decodeTables->nonParallel.find(_opcode);
 	}
 
 	const OpcodeInfo* Opcodes::findParallelMoveOpcodeInfo(TWord _opcode) const
 	{
 		assert(isParallelOpcode(_opcode));
-		return findOpcodeInfo(_opcode, m_opcodesMove);
+		return m_decodeTables->move.find(_opcode);
 	}
 
 	const OpcodeInfo* Opcodes::findParallelAluOpcodeInfo(TWord _opcode) const
 	{
 		assert(isParallelOpcode(_opcode));
-		return findOpcodeInfo(_opcode, m_opcodesAlu);
+		return m_decodeTables->alu.find(_opcode);
 	}
 
 	const OpcodeInfo& Opcodes::getOpcodeInfoAt(size_t _index)
@@ -119,6 +165,16 @@ namespace dsp56k
 	}
 
 	uint32_t Opcodes::getInstructionTypes(const TWord _op, Instruction& _a, Instruction& _b) const
+	{
+		return getInstructionTypes(_op, _a, _b, false);
+	}
+
+	uint32_t Opcodes::getInstructionTypesLinear(const TWord _op, Instruction& _a, Instruction& _b) const
+	{
+		return getInstructionTypes(_op, _a, _b, true);
+	}
+
+	uint32_t Opcodes::getInstructionTypes(const TWord _op, Instruction& _a, Instruction& _b, const bool _linear) const
 	{
 		if(!_op)
 		{
@@ -131,15 +187,15 @@ namespace dsp56k
 
 		if(isNonParallelOpcode(_op))
 		{
-			const auto oi = findNonParallelOpcodeInfo(_op);
+			const auto oi = _linear ? findOpcodeInfo(_op, m_opcodesNonParallel) : findNonParallelOpcodeInfo(_op);
 
 			if(oi)
 				_a = oi->getInstruction();
 			return 1;
 		}
 
-		const auto* oiAlu = (_op & 0xff) ? findParallelAluOpcodeInfo(_op) : nullptr;
-		const auto* oiMove = findParallelMoveOpcodeInfo(_op);
+		const auto* oiAlu = (_op & 0xff) ? (_linear ? findOpcodeInfo(_op, m_opcodesAlu) : findParallelAluOpcodeInfo(_op)) : nullptr;
+		const auto* oiMove = _linear ? findOpcodeInfo(_op, m_opcodesMove) : findParallelMoveOpcodeInfo(_op);
 
 		uint32_t res = 0;
 
@@ -207,12 +263,17 @@ namespace dsp56k
 	}
 
 	const OpcodeInfo* Opcodes::findOpcodeInfo(TWord _opcode, const std::vector<const OpcodeInfo*>& _opcodes)
+	{
+		return findOpcodeInfo(_opcode, _opcodes.data(), _opcodes.data() + _opcodes.size());
+	}
+
+	const OpcodeInfo* Opcodes::findOpcodeInfo(TWord _opcode, const OpcodeInfo* const* _begin, const OpcodeInfo* const* _end)
 	{
 		const OpcodeInfo* res = nullptr;
 
-		for (size_t i=0; i<_opcodes.size(); ++i)
+		for (auto it = _begin; it != _end; ++it)
 		{
-			const auto* oi = _opcodes[i];
+			const auto* oi = *it;
 
 			if(match(*oi, _opcode))
 			{
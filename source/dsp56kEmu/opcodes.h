@@ -253,8 +253,36 @@ namespace dsp56k
 		return false;
 	}
 
+	// Opcodes that can match an opcode word, grouped by the value of a range of bits of that word. Only a few
+	// candidates per group need to be matched instead of all opcodes of a list
+	class OpcodeDecodeTable
+	{
+	public:
+		OpcodeDecodeTable(uint32_t _shift, uint32_t _bitCount, const std::vector<const OpcodeInfo*>& _opcodes);
+
+		const OpcodeInfo* find(TWord _opcode) const;
+
+	private:
+		const uint32_t m_shift;
+		const uint32_t m_mask;
+
+		std::vector<uint32_t> m_bucketOffsets;
+		std::vector<const OpcodeInfo*> m_candidates;
+	};
+
+	struct OpcodeDecodeTables
+	{
+		OpcodeDecodeTables(const std::vector<const OpcodeInfo*>& _nonParallel, const std::vector<const OpcodeInfo*>& _move, const std::vector<const OpcodeInfo*>& _alu);
+
+		const OpcodeDecodeTable nonParallel;
+		const OpcodeDecodeTable move;
+		const OpcodeDecodeTable alu;
+	};
+
 	class Opcodes
 	{
+		friend class OpcodeDecodeTable;
+
 	public:
 		Opcodes();
 
@@ -278,15 +306,21 @@ namespace dsp56k
 		uint32_t getOpcodeLength(TWord _op, Instruction _instA, Instruction _instB) const;
 		bool writesToPMemory(TWord _op) const;
 		uint32_t getInstructionTypes(TWord _op, Instruction& _a, Instruction& _b) const;
+		uint32_t getInstructionTypesLinear(TWord _op, Instruction& _a, Instruction& _b) const;	// matches all opcodes without using the decode tables, used to verify them
 		bool getRegisters(RegisterMask& _written, RegisterMask& _read, TWord _opA, TWord _opB) const;
 		static uint32_t getFlags(Instruction _instA, Instruction _instB);
 		bool getMemoryAddress(TWord& _addr, EMemArea& _area, TWord opA, TWord opB) const;
 	private:
+		uint32_t getInstructionTypes(TWord _op, Instruction& _a, Instruction& _b, bool _linear) const;
+
 		static const OpcodeInfo* findOpcodeInfo(TWord _opcode, const std::vector<const OpcodeInfo*>& _opcodes);
+		static const OpcodeInfo* findOpcodeInfo(TWord _opcode, const OpcodeInfo* const* _begin, const OpcodeInfo* const* _end);
 		
 		std::vector<const OpcodeInfo*> m_opcodesNonParallel;
 		std::vector<const OpcodeInfo*> m_opcodesMove;
 		std::vector<const OpcodeInfo*> m_opcodesAlu;
+
+		const OpcodeDecodeTables* m_decodeTables = nullptr;
 	};
 
 	// _____________________________________________
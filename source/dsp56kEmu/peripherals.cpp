@@ -7,8 +7,39 @@
 #include "interrupts.h"
 #include "logging.h"
 
+#include <algorithm>
+
 namespace dsp56k
 {
+	namespace
+	{
+		// side effects of registers that JIT code accesses directly, see PeripheralRegisterAccess
+		void esaiReadStatusRegister(void* _esai, TWord, TWord)
+		{
+			static_cast<Esai*>(_esai)->readStatusRegister();
+		}
+
+		void esaiWriteTX(void* _esai, const TWord _index, const TWord _value)
+		{
+			static_cast<Esai*>(_esai)->writeTX(_index, _value);
+		}
+
+		void hdi08ReadStatusRegister(void* _hdi08, TWord, TWord)
+		{
+			static_cast<HDI08*>(_hdi08)->readStatusRegister();
+		}
+
+		void hdi08WriteTX(void* _hdi08, TWord, const TWord _value)
+		{
+			static_cast<HDI08*>(_hdi08)->writeTX(_value);
+		}
+	}
+
+	uint32_t IPeripherals::getInstructionsUntilNextEvent() const
+	{
+		return DSP::PeripheralsNoEvent;
+	}
+
 	// _____________________________________________________________________________
 	// Peripherals
 	//
@@ -55,6 +86,12 @@ namespace dsp56k
 		m_essi.exec();
 	}
 
+	uint32_t Peripherals56303::getInstructionsUntilNextEvent() const
+	{
+		// ESSI is not clocked, it has to be polled
+		return DSP::PeripheralsProcessingStepSize;
+	}
+
 	void Peripherals56303::reset()
 	{
 		m_essi.reset();
@@ -191,62 +228,104 @@ namespace dsp56k
 		return value;
 	}
 
-	const TWord* Peripherals56362::readAsPtr(TWord _addr, Instruction _inst)
+	PeripheralRegisterAccess Peripherals56362::getReadAccess(const TWord _addr, Instruction _inst)
+	{
+		using Access = PeripheralRegisterAccess;
+
+		switch (_addr)
+		{
+		case HDI08::HSR:			return Access::callbackRead(&hdi08ReadStatusRegister, &m_hdi08, m_hdi08.getStatusRegister());
+		case HDI08::HCR:			return Access::memory(m_hdi08.readControlRegister());
+		case HDI08::HPCR:			return Access::memory(m_hdi08.readPortControlRegister());
+		case HDI08::HDR:			return Access::memory(m_hdi08.readHDR());
+
+		case Esai::M_RCR:			return Access::memory(m_esai.readReceiveControlRegister());
+		case Esai::M_RCCR:			return Access::memory(m_esai.readReceiveClockControlRegister());
+		case Esai::M_SAISR:			return Access::callbackRead(&esaiReadStatusRegister, &m_esai, m_esai.getStatusRegister());
+		case Esai::M_TCR:			return Access::memory(m_esai.readTransmitControlRegister());
+		case Esai::M_TCCR:			return Access::memory(m_esai.readTransmitClockControlRegister());
+		case Esai::M_TSMA:			return Access::memory(m_esai.readTSMA());
+		case Esai::M_TSMB:			return Access::memory(m_esai.readTSMB());
+
+		case Timers::M_TCSR0:		return Access::memory(m_timers.readTCSR(0));	// TIMER0 Control/Status Register
+		case Timers::M_TCSR1:		return Access::memory(m_timers.readTCSR(1));	// TIMER1 Control/Status Register
+		case Timers::M_TCSR2:		return Access::memory(m_timers.readTCSR(2));	// TIMER2 Control/Status Register
+		case Timers::M_TLR0:		return Access::memory(m_timers.readTLR(0));	// TIMER0 Load Reg
+		case Timers::M_TLR1:		return Access::memory(m_timers.readTLR(1));	// TIMER1 Load Reg
+		case Timers::M_TLR2:		return Access::memory(m_timers.readTLR(2));	// TIMER2 Load Reg
+		case Timers::M_TCPR0:		return Access::memory(m_timers.readTCPR(0));	// TIMER0 Compare Register
+		case Timers::M_TCPR1:		return Access::memory(m_timers.readTCPR(1));	// TIMER1 Compare Register
+		case Timers::M_TCPR2:		return Access::memory(m_timers.readTCPR(2));	// TIMER2 Compare Register
+		case Timers::M_TCR0:		return Access::memory(m_timers.readTCR(0));	// TIMER0 Count Register
+		case Timers::M_TCR1:		return Access::memory(m_timers.readTCR(1));	// TIMER1 Count Register
+		case Timers::M_TCR2:		return Access::memory(m_timers.readTCR(2));	// TIMER2 Count Register
+
+		case Timers::M_TPLR:		return Access::memory(m_timers.readTPLR());	// TIMER Prescaler Load Register
+		case Timers::M_TPCR:		return Access::memory(m_timers.readTPCR());	// TIMER Prescalar Count Register
+
+		case XIO_DCR5:				return Access::memory(m_dma.getDCR(5));		// DMA 5 Control Register
+		case XIO_DCO5:				return Access::memory(m_dma.getDCO(5));		// DMA 5 Counter
+		case XIO_DDR5:				return Access::memory(m_dma.getDDR(5));		// DMA 5 Destination Address Register
+		case XIO_DSR5:				return Access::memory(m_dma.getDSR(5));		// DMA 5 Source Address Register
+
+		case XIO_DCR4:				return Access::memory(m_dma.getDCR(4));		// DMA 4 Control Register
+		case XIO_DCO4:				return Access::memory(m_dma.getDCO(4));		// DMA 4 Counter
+		case XIO_DDR4:				return Access::memory(m_dma.getDDR(4));		// DMA 4 Destination Address Register
+		case XIO_DSR4:				return Access::memory(m_dma.getDSR(4));		// DMA 4 Source Address Register
+
+		case XIO_DCR3:				return Access::memory(m_dma.getDCR(3));		// DMA 3 Control Register
+		case XIO_DCO3:				return Access::memory(m_dma.getDCO(3));		// DMA 3 Counter
+		case XIO_DDR3:				return Access::memory(m_dma.getDDR(3));		// DMA 3 Destination Address Register
+		case XIO_DSR3:				return Access::memory(m_dma.getDSR(3));		// DMA 3 Source Address Register
+
+		case XIO_DCR2:				return Access::memory(m_dma.getDCR(2));		// DMA 2 Control Register
+		case XIO_DCO2:				return Access::memory(m_dma.getDCO(2));		// DMA 2 Counter
+		case XIO_DDR2:				return Access::memory(m_dma.getDDR(2));		// DMA 2 Destination Address Register
+		case XIO_DSR2:				return Access::memory(m_dma.getDSR(2));		// DMA 2 Source Address Register
+
+		case XIO_DCR1:				return Access::memory(m_dma.getDCR(1));		// DMA 1 Control Register
+		case XIO_DCO1:				return Access::memory(m_dma.getDCO(1));		// DMA 1 Counter
+		case XIO_DDR1:				return Access::memory(m_dma.getDDR(1));		// DMA 1 Destination Address Register
+		case XIO_DSR1:				return Access::memory(m_dma.getDSR(1));		// DMA 1 Source Address Register
+
+		case XIO_DCR0:				return Access::memory(m_dma.getDCR(0));		// DMA 0 Control Register
+		case XIO_DCO0:				return Access::memory(m_dma.getDCO(0));		// DMA 0 Counter
+		case XIO_DDR0:				return Access::memory(m_dma.getDDR(0));		// DMA 0 Destination Address Register
+		case XIO_DSR0:				return Access::memory(m_dma.getDSR(0));		// DMA 0 Source Address Register
+
+		case XIO_DSTR:				return Access::memory(m_dma.getDSTR());		// DMA Status Register
+
+		case M_AAR0:
+		case M_AAR1:
+		case M_AAR2:
+		case M_AAR3:
+		case 0xffffff:
+		case 0xfffffe:				return Access::memory(m_mem[_addr - XIO_Reserved_High_First]);
+		}
+
+		return {};
+	}
+
+	PeripheralRegisterAccess Peripherals56362::getWriteAccess(const TWord _addr)
 	{
+		using Access = PeripheralRegisterAccess;
+
 		switch (_addr)
 		{
-		case Timers::M_TCSR0:		return &m_timers.readTCSR(0);	// TIMER0 Control/Status Register
-		case Timers::M_TCSR1:		return &m_timers.readTCSR(1);	// TIMER1 Control/Status Register
-		case Timers::M_TCSR2:		return &m_timers.readTCSR(2);	// TIMER2 Control/Status Register
-		case Timers::M_TLR0:		return &m_timers.readTLR(0);	// TIMER0 Load Reg
-		case Timers::M_TLR1:		return &m_timers.readTLR(1);	// TIMER1 Load Reg
-		case Timers::M_TLR2:		return &m_timers.readTLR(2);	// TIMER2 Load Reg
-		case Timers::M_TCPR0:		return &m_timers.readTCPR(0);	// TIMER0 Compare Register
-		case Timers::M_TCPR1:		return &m_timers.readTCPR(1);	// TIMER1 Compare Register
-		case Timers::M_TCPR2:		return &m_timers.readTCPR(2);	// TIMER2 Compare Register
-		case Timers::M_TCR0:		return &m_timers.readTCR(0);	// TIMER0 Count Register
-		case Timers::M_TCR1:		return &m_timers.readTCR(1);	// TIMER1 Count Register
-		case Timers::M_TCR2:		return &m_timers.readTCR(2);	// TIMER2 Count Register
-
-		case Timers::M_TPLR:		return &m_timers.readTPLR();	// TIMER Prescaler Load Register
-		case Timers::M_TPCR:		return &m_timers.readTPCR();	// TIMER Prescalar Count Register
-
-		case XIO_DCR5:				return &m_dma.getDCR(5);		// DMA 5 Control Register
-		case XIO_DCO5:				return &m_dma.getDCO(5);		// DMA 5 Counter
-		case XIO_DDR5:				return &m_dma.getDDR(5);		// DMA 5 Destination Address Register
-		case XIO_DSR5:				return &m_dma.getDSR(5);		// DMA 5 Source Address Register
-
-		case XIO_DCR4:				return &m_dma.getDCR(4);		// DMA 4 Control Register
-		case XIO_DCO4:				return &m_dma.getDCO(4);		// DMA 4 Counter
-		case XIO_DDR4:				return &m_dma.getDDR(4);		// DMA 4 Destination Address Register
-		case XIO_DSR4:				return &m_dma.getDSR(4);		// DMA 4 Source Address Register
-
-		case XIO_DCR3:				return &m_dma.getDCR(3);		// DMA 3 Control Register
-		case XIO_DCO3:				return &m_dma.getDCO(3);		// DMA 3 Counter
-		case XIO_DDR3:				return &m_dma.getDDR(3);		// DMA 3 Destination Address Register
-		case XIO_DSR3:				return &m_dma.getDSR(3);		// DMA 3 Source Address Register
-
-		case XIO_DCR2:				return &m_dma.getDCR(2);		// DMA 2 Control Register
-		case XIO_DCO2:				return &m_dma.getDCO(2);		// DMA 2 Counter
-		case XIO_DDR2:				return &m_dma.getDDR(2);		// DMA 2 Destination Address Register
-		case XIO_DSR2:				return &m_dma.getDSR(2);		// DMA 2 Source Address Register
-
-		case XIO_DCR1:				return &m_dma.getDCR(1);		// DMA 1 Control Register
-		case XIO_DCO1:				return &m_dma.getDCO(1);		// DMA 1 Counter
-		case XIO_DDR1:				return &m_dma.getDDR(1);		// DMA 1 Destination Address Register
-		case XIO_DSR1:				return &m_dma.getDSR(1);		// DMA 1 Source Address Register
-
-		case XIO_DCR0:				return &m_dma.getDCR(0);		// DMA 0 Control Register
-		case XIO_DCO0:				return &m_dma.getDCO(0);		// DMA 0 Counter
-		case XIO_DDR0:				return &m_dma.getDDR(0);		// DMA 0 Destination Address Register
-		case XIO_DSR0:				return &m_dma.getDSR(0);		// DMA 0 Source Address Register
-
-		case XIO_DSTR:				return &m_dma.getDSTR();		// DMA Status Register
+		case HDI08::HOTX:			return Access::callbackWrite(&hdi08WriteTX, &m_hdi08);
+
+		case Esai::M_TX0:
+		case Esai::M_TX1:
+		case Esai::M_TX2:
+		case Esai::M_TX3:
+		case Esai::M_TX4:
+		case Esai::M_TX5:			return Access::callbackWrite(&esaiWriteTX, &m_esai, _addr - Esai::M_TX0);
 		}
 
-		return nullptr;
+		return {};
 	}
 
+
 	void Peripherals56362::write(const TWord _addr, const TWord _val)
 	{
 		switch (_addr)
@@ -376,6 +455,13 @@ namespace dsp56k
 		m_dma.exec();
 	}
 
+	uint32_t Peripherals56362::getInstructionsUntilNextEvent() const
+	{
+		auto delay = std::min(m_esaiClock.getInstructionsUntilNextEvent(), m_hdi08.getInstructionsUntilNextEvent());
+		if (!m_disableTimers) delay = std::min(delay, m_timers.getInstructionsUntilNextEvent());
+		return std::min(delay, m_dma.getInstructionsUntilNextEvent());
+	}
+
 	void Peripherals56362::reset()
 	{
 		m_hdi08.reset();
@@ -595,6 +681,39 @@ namespace dsp56k
 		m_mem[_addr - XIO_Reserved_High_First] = _val;
 	}
 
+	PeripheralRegisterAccess Peripherals56367::getReadAccess(const TWord _addr, Instruction _inst)
+	{
+		using Access = PeripheralRegisterAccess;
+
+		switch (_addr)
+		{
+		case Esai::M_RCR_1:			return Access::memory(m_esai.readReceiveControlRegister());
+		case Esai::M_RCCR_1:		return Access::memory(m_esai.readReceiveClockControlRegister());
+		case Esai::M_SAISR_1:		return Access::callbackRead(&esaiReadStatusRegister, &m_esai, m_esai.getStatusRegister());
+		case Esai::M_TCR_1:			return Access::memory(m_esai.readTransmitControlRegister());
+		case Esai::M_TCCR_1:		return Access::memory(m_esai.readTransmitClockControlRegister());
+		case Esai::M_TSMA_1:		return Access::memory(m_esai.readTSMA());
+		case Esai::M_TSMB_1:		return Access::memory(m_esai.readTSMB());
+		}
+
+		return {};
+	}
+
+	PeripheralRegisterAccess Peripherals56367::getWriteAccess(const TWord _addr)
+	{
+		switch (_addr)
+		{
+		case Esai::M_TX0_1:
+		case Esai::M_TX1_1:
+		case Esai::M_TX2_1:
+		case Esai::M_TX3_1:
+		case Esai::M_TX4_1:
+		case Esai::M_TX5_1:		return PeripheralRegisterAccess::callbackWrite(&esaiWriteTX, &m_esai, _addr - Esai::M_TX0_1);
+		}
+
+		return {};
+	}
+
 	void Peripherals56367::exec()
 	{
 	}
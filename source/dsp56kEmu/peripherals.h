@@ -75,6 +75,54 @@ namespace dsp56k
 		XIO_IPRC = XIO_Reserved_High_Last	// Interrupt Priority Register Core
 	};
 
+	// Describes how JIT code accesses a peripheral register at a fixed address
+	struct PeripheralRegisterAccess
+	{
+		enum class Type
+		{
+			Dynamic,		// IPeripherals::read() / write() is called
+			Memory,			// reads load the cell directly, the register has no side effects
+			Callback,		// reads call the callback and load the cell afterwards, writes call the callback with the value
+		};
+
+		using Callback = void(*)(void* _object, TWord _index, TWord _value);
+
+		Type type = Type::Dynamic;
+		const TWord* cell = nullptr;
+		Callback callback = nullptr;
+		void* object = nullptr;
+		TWord index = 0;
+
+		static PeripheralRegisterAccess memory(const TWord& _cell)
+		{
+			PeripheralRegisterAccess a;
+			a.type = Type::Memory;
+			a.cell = &_cell;
+			return a;
+		}
+
+		static PeripheralRegisterAccess callbackRead(const Callback _callback, void* _object, const TWord& _cell, const TWord _index = 0)
+		{
+			PeripheralRegisterAccess a;
+			a.type = Type::Callback;
+			a.cell = &_cell;
+			a.callback = _callback;
+			a.object = _object;
+			a.index = _index;
+			return a;
+		}
+
+		static PeripheralRegisterAccess callbackWrite(const Callback _callback, void* _object, const TWord _index = 0)
+		{
+			PeripheralRegisterAccess a;
+			a.type = Type::Callback;
+			a.callback = _callback;
+			a.object = _object;
+			a.index = _index;
+			return a;
+		}
+	};
+
 	class IPeripherals
 	{
 	public:
@@ -91,13 +139,19 @@ namespace dsp56k
 		};
 
 		virtual TWord read(TWord _addr, Instruction _inst) = 0;
-		virtual const TWord* readAsPtr(TWord _addr, Instruction _inst) = 0;
 		virtual void write(TWord _addr, TWord _value) = 0;
+
+		// used by the JIT for accesses to fixed addresses, registers that are not published are accessed via read() / write()
+		virtual PeripheralRegisterAccess getReadAccess(TWord _addr, Instruction _inst) { return {}; }
+		virtual PeripheralRegisterAccess getWriteAccess(TWord _addr) { return {}; }
 		virtual void exec() = 0;
 		virtual void reset() = 0;
 		virtual void setSymbols(Disassembler& _disasm) const = 0;
 		virtual void terminate() = 0;
 
+		// number of instructions until exec() needs to be called again, see DSP::setEventDrivenPeripherals
+		virtual uint32_t getInstructionsUntilNextEvent() const;
+
 	private:
 		DSP* m_dsp = nullptr;
 	};
@@ -105,7 +159,6 @@ namespace dsp56k
 	class PeripheralsNop : public IPeripherals
 	{
 		TWord read(TWord _addr, Instruction _inst) override { return 0; }
-		const TWord* readAsPtr(TWord _addr, Instruction _inst) override { return nullptr; }
 		void write(TWord _addr, TWord _value) override {}
 		void exec() override {}
 		void reset() override {}
@@ -127,11 +180,11 @@ namespace dsp56k
 		Peripherals56303();
 		
 		TWord read(TWord _addr, Instruction _inst) override;
-		const TWord* readAsPtr(TWord _addr, Instruction _inst) override { return nullptr; }
 		void write(TWord _addr, TWord _val) override;
 
 		void exec() override;
 		void reset() override;
+		uint32_t getInstructionsUntilNextEvent() const override;
 
 		Essi& getEssi()	{ return m_essi; }
 		HI08& getHI08()	{ return m_hi08; }
@@ -161,11 +214,14 @@ namespace dsp56k
 		Peripherals56362(Peripherals56367* _peripherals56367 = nullptr);
 		
 		TWord read(TWord _addr, Instruction _inst) override;
-		const TWord* readAsPtr(TWord _addr, Instruction _inst) override;
 		void write(TWord _addr, TWord _val) override;
 
+		PeripheralRegisterAccess getReadAccess(TWord _addr, Instruction _inst) override;
+		PeripheralRegisterAccess getWriteAccess(TWord _addr) override;
+
 		void exec() override;
 		void reset() override;
+		uint32_t getInstructionsUntilNextEvent() const override;
 
 		EsaiClock& getEsaiClock() { return m_esaiClock; }
 		Esai& getEsai()		{ return m_esai; }
@@ -196,9 +252,11 @@ namespace dsp56k
 		Peripherals56367();
 
 		TWord read(TWord _addr, Instruction _inst) override;
-		const TWord* readAsPtr(TWord _addr, Instruction _inst) override { return nullptr; }
 		void write(TWord _addr, TWord _val) override;
 
+		PeripheralRegisterAccess getReadAccess(TWord _addr, Instruction _inst) override;
+		PeripheralRegisterAccess getWriteAccess(TWord _addr) override;
+
 		void exec() override;
 		void reset() override;
 
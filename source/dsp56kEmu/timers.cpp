@@ -4,6 +4,8 @@
 
 #include "timers.h"
 
+#include <algorithm>
+
 namespace dsp56k
 {
 	void Timers::exec()
@@ -15,8 +17,11 @@ namespace dsp56k
 
 		// If the timer runs on internal clock, the frequency is DSP / 2
 		const auto clock = m_peripherals.getDSP().getInstructionCounter();
-		const auto diff = delta(clock, m_lastClock) >> 1;
-		m_lastClock = clock;
+		const auto elapsed = delta(clock, m_lastClock);
+		const auto diff = elapsed >> 1;
+
+		// an odd instruction is carried over, event driven steps are not a multiple of two instructions apart
+		m_lastClock = clock - (elapsed & 1);
 
 //		m_prescalerClock ^= 1;
 //		m_tpcr -= m_prescalerClock;
@@ -32,6 +37,32 @@ namespace dsp56k
 		}
 	}
 
+	uint32_t Timers::getInstructionsUntilNextEvent() const
+	{
+		uint32_t ticks = DSP::PeripheralsNoEvent;
+
+		for (const auto& t : m_timers)
+		{
+			if (!t.m_tcsr.test(Timer::M_TE))
+				continue;
+
+			// the counter is incremented before it is compared, see execTimer
+			const TWord toCompare = ((t.m_tcpr - t.m_tcr - 1) & 0xFFFFFF) + 1;
+			const TWord toOverflow = 0x1000000 - t.m_tcr;
+
+			ticks = std::min(ticks, std::min(toCompare, toOverflow));
+		}
+
+		if (ticks == DSP::PeripheralsNoEvent)
+			return ticks;
+
+		// internal clock runs at DSP / 2. Ticks are counted from the last step, not from now
+		const auto instructions = ticks << 1;
+		const auto elapsed = delta(m_peripherals.getDSP().getInstructionCounter(), m_lastClock);
+
+		return instructions > elapsed ? instructions - elapsed : 1;
+	}
+
 	void Timers::execTimer(Timer& _t, uint32_t _index) const
 	{
 		if (!_t.m_tcsr.test(Timer::M_TE))
@@ -91,5 +122,7 @@ namespace dsp56k
 		timerFlagReset<Timer::M_TCF>(t.m_tcsr, _val);
 
 		t.m_tcsr = _val;
+
+		m_peripherals.getDSP().schedulePeripheralsEvent(getInstructionsUntilNextEvent());
 	}
 }
@@ -105,6 +105,7 @@ namespace dsp56k
 		Timers(IPeripherals& _peripherals) : m_peripherals(_peripherals) {}
 		void exec();
 		void execTimer(Timer& _t, uint32_t _index) const;
+		uint32_t getInstructionsUntilNextEvent() const;
 
 		void writeTCSR(int _index, TWord _val);
 
@@ -1,5 +1,14 @@
 #include "unittests.h"
 
+#include <chrono>
+#include <map>
+#include <random>
+
+#include "dspconfig.h"
+#include "jitblockruntimedata.h"
+#include "jitsingleopcache.h"
+#include "jitunittests.h"
+
 namespace dsp56k
 {
 	static DefaultMemoryValidator g_defaultMemoryValidator;
@@ -70,6 +79,9 @@ namespace dsp56k
 
 		move();
 		parallel();
+
+		opcodeDecodeTable();
+		opcodeAnalysisCache();
 	}
 
 	void UnitTests::aguModulo()
@@ -2257,4 +2269,223 @@ namespace dsp56k
 			verify(dsp.regs().b.var == 0x88999999aaaaaa);
 		});
 	}
+
+	void UnitTests::opcodeDecodeTable()
+	{
+		const auto& opcodes = dsp.opcodes();
+
+		// the decode tables need to resolve to the same instructions as matching against all opcodes
+		for(TWord op=0; op<0x1000000; ++op)
+		{
+			Instruction instA, instB, refA, refB;
+			opcodes.getInstructionTypes(op, instA, instB);
+			opcodes.getInstructionTypesLinear(op, refA, refB);
+			verify(instA == refA && instB == refB);
+		}
+	}
+
+	void UnitTests::runBenchmarks()
+	{
+		const Opcodes opcodes;
+
+		// decode all possible opcode words, once via the decode tables and once by matching against all opcodes
+		auto decodeAll = [&](const bool _linear)
+		{
+			const auto t0 = std::chrono::high_resolution_clock::now();
+
+			uint32_t count = 0;
+
+			for(TWord op=0; op<0x1000000; ++op)
+			{
+				Instruction instA, instB;
+				count += _linear ? opcodes.getInstructionTypesLinear(op, instA, instB) : opcodes.getInstructionTypes(op, instA, instB);
+			}
+
+			const auto t1 = std::chrono::high_resolution_clock::now();
+			const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+
+			LOG("Decoded 2^24 opcode words (" << count << " instructions) " << (_linear ? "linear" : "via decode tables") << " in " << ms << " ms");
+		};
+
+		decodeAll(true);
+		decodeAll(false);
+
+		// Single-op block lookups as done by JitBlockChain::createFromSingleOpCache, two-word key first, then one-word key.
+		// Addresses have one to four blocks each, most lookups are misses. Compares a std::map per address, which is how
+		// blocks were stored before JitSingleOpCache, with the chain-wide table
+		for(const TWord addressCount : {16u, 4096u, 65536u})
+		{
+			constexpr uint32_t lookupCount = 1 << 22;
+
+			std::mt19937 rand(0x56300);
+
+			std::vector<std::map<uint64_t, JitBlockRuntimeData*>> maps(addressCount);
+			JitSingleOpCache table;
+
+			// only the pointer values matter, blocks are never dereferenced
+			auto* block = reinterpret_cast<JitBlockRuntimeData*>(uintptr_t(0x1000));
+
+			for(TWord pc=0; pc<addressCount; ++pc)
+			{
+				const auto count = 1 + (rand() & 3);
+				for(uint32_t i=0; i<count; ++i)
+				{
+					const auto key = JitBlockRuntimeData::getSingleOpCacheKey(i << 1, JitBlockRuntimeData::SingleOpCacheIgnoreWordB);
+					maps[pc].insert(std::make_pair(key, block));
+					table.add(pc, key, block);
+				}
+			}
+
+			std::vector<std::pair<TWord, TWord>> lookups(lookupCount);
+			for (auto& l : lookups)
+				l = std::make_pair(rand() % addressCount, rand() & 15);		// odd opcodes and opcodes >= 8 miss
+
+			auto lookupAll = [&](const char* _name, const auto& _find)
+			{
+				const auto t0 = std::chrono::high_resolution_clock::now();
+
+				uint32_t found = 0;
+
+				for (const auto& l : lookups)
+				{
+					auto* b = _find(l.first, JitBlockRuntimeData::getSingleOpCacheKey(l.second, 0));
+					if(!b)
+						b = _find(l.first, JitBlockRuntimeData::getSingleOpCacheKey(l.second, JitBlockRuntimeData::SingleOpCacheIgnoreWordB));
+					found += b ? 1 : 0;
+				}
+
+				const auto t1 = std::chrono::high_resolution_clock::now();
+				const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+
+				LOG("Single-op cache lookups at " << addressCount << " addresses via " << _name << ": " << (static_cast<double>(ns) / lookupCount) << " ns per lookup, " << found << " hits");
+			};
+
+			lookupAll("std::map per address", [&](const TWord _pc, const uint64_t _key) -> JitBlockRuntimeData*
+			{
+				const auto& m = maps[_pc];
+				const auto it = m.find(_key);
+				return it != m.end() ? it->second : nullptr;
+			});
+
+			lookupAll("JitSingleOpCache", [&](const TWord _pc, const uint64_t _key)
+			{
+				return table.find(_pc, _key);
+			});
+		}
+
+		// Interpreter timings. Programs start at $100 and end with a jmp to $1c0, returns DSP instructions per microsecond (MIPS)
+		auto measureInterpreter = [](const std::vector<TWord>& _program, const uint32_t _runCount, const std::function<void(DSP&)>& _init)
+		{
+			Peripherals56362 peripheralsX;
+			Peripherals56367 peripheralsY;
+			Memory memory(g_defaultMemoryValidator, 0x200);
+			DSP interpreter(memory, &peripheralsX, &peripheralsY);
+
+			interpreter.setUseJit(false);
+
+			for(size_t i=0; i<_program.size(); ++i)
+				memory.set(MemArea_P, 0x100 + static_cast<TWord>(i), _program[i]);
+
+			if(_init)
+				_init(interpreter);
+
+			const auto t0 = std::chrono::high_resolution_clock::now();
+
+			for(uint32_t r=0; r<_runCount; ++r)
+			{
+				interpreter.setPC(0x100);
+
+				while(interpreter.getPC().var != 0x1c0)
+					interpreter.exec();
+			}
+
+			const auto t1 = std::chrono::high_resolution_clock::now();
+			const auto us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+
+			return static_cast<double>(interpreter.getInstructionCounter()) / us;
+		};
+
+		// a loop of $100000 iterations without DO, the interpreter returns from exec() after each instruction
+		const std::vector<TWord> countdownLoop =
+		{
+			0x44f400, 0x000001,		// move #>$1,x0
+			0x56f400, 0x100000,		// move #>$100000,a
+			0x20001b,				// clr b
+			0x200048,				// $105: add x0,b
+			0x200044,				// sub x0,a
+			0x0e2105,				// jne $105
+			0x0c01c0				// jmp $1c0
+		};
+
+		const auto stepped = measureInterpreter(countdownLoop, 4, {});
+		const auto eventDriven = measureInterpreter(countdownLoop, 4, [](DSP& _dsp)
+		{
+			_dsp.setEventDrivenPeripherals(true);
+		});
+
+		LOG("Interpreter countdown loop: " << stepped << " MIPS, with event driven peripherals: " << eventDriven << " MIPS");
+
+		// A 16-tap FIR filter run $fff times. Its parallel move does not access A or B and runs without latching.
+		// Writing b instead of y0 makes the same loop latch A and B for every mac
+		auto fir16 = [](const TWord _mac)
+		{
+			return std::vector<TWord>
+			{
+				0x06ff8f, 0x00010a,		// do #$fff,$10b
+				0x60f400, 0x000000,		// move #>$0,r0
+				0x64f400, 0x000000,		// move #>$0,r4
+				0x200013,				// clr a
+				0x061080, 0x000109,		// do #$10,$10a
+				_mac,
+				0x000000,				// nop
+				0x0c01c0				// jmp $1c0
+			};
+		};
+
+		const auto firLatched = measureInterpreter(fir16(0xf398d2), 40, {});		// mac y0,x0,a x:(r0)+,x0 y:(r4)+,b
+		const auto firNoLatch = measureInterpreter(fir16(0xf098d2), 40, {});		// mac y0,x0,a x:(r0)+,x0 y:(r4)+,y0
+
+		LOG("Interpreter 16-tap FIR: " << firLatched << " MIPS with latching, " << firNoLatch << " MIPS without");
+
+		// the same programs as closure blocks, the handlers are resolved once per block instead of being looked up per op
+		const auto useClosureBlocks = [](DSP& _dsp)
+		{
+			JitConfig config;
+			config.closureBlocks = true;
+			_dsp.getJit().setConfig(config);
+			_dsp.setUseJit(true);
+		};
+
+		const auto countdownClosures = measureInterpreter(countdownLoop, 4, useClosureBlocks);
+		const auto firClosures = measureInterpreter(fir16(0xf098d2), 40, useClosureBlocks);
+
+		LOG("Closure blocks: countdown loop " << countdownClosures << " MIPS, 16-tap FIR " << firClosures << " MIPS");
+
+		if constexpr (g_jitSupported)
+			JitUnittests::runProgramBenchmarks();
+	}
+
+	void UnitTests::opcodeAnalysisCache()
+	{
+		auto& mem = dsp.memory();
+
+		constexpr TWord pc = 0x80;
+
+		mem.set(MemArea_P, pc, 0x0c0200);	// jmp $200
+
+		{
+			const auto& a = mem.getOpcodeAnalysis(pc);
+			verify(a.instA == Jmp_xxx && a.length == 1 && a.branchTarget == 0x200 && a.loopEnd == g_invalidAddress);
+		}
+
+		// a cached entry must not survive a write to P memory
+		mem.set(MemArea_P, pc, 0x000000);	// nop
+		verify(mem.getOpcodeAnalysis(pc).instA == Nop);
+
+		// neither if P memory is modified directly
+		mem.getMemAreaPtr(MemArea_P)[pc] = 0x0c0300;
+		verify(mem.getOpcodeAnalysis(pc).branchTarget == 0x300);
+
+		mem.set(MemArea_P, pc, 0);
+	}
 }
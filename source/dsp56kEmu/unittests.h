@@ -19,6 +19,10 @@ namespace  dsp56k
 {
 	class UnitTests
 	{
+	public:
+		// timings that are too slow or too noisy for the regular test run, dsp56kTestRunner runs them with -benchmark
+		static void runBenchmarks();
+
 	protected:
 		UnitTests();
 
@@ -87,6 +91,9 @@ namespace  dsp56k
 		void move();
 		void parallel();
 
+		void opcodeDecodeTable();
+		void opcodeAnalysisCache();
+
 		Peripherals56362 peripheralsX;
 		Peripherals56367 peripheralsY;
 		Memory mem;
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string>
 
 #include "dsp56kEmu/dspconfig.h"
 #include "dsp56kEmu/jitunittests.h"
@@ -6,6 +7,13 @@
 
 int main(int _argc, char* _argv[])
 {
+	if(_argc > 1 && std::string(_argv[1]) == "-benchmark")
+	{
+		std::cout << "Running Benchmarks..." << std::endl;
+		dsp56k::UnitTests::runBenchmarks();
+		return 0;
+	}
+
 	std::cout << "Running Unit Tests..." << std::endl;
 	try
 	{